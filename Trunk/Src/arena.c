@@ -0,0 +1,99 @@
+/**********************************************************************
+ * Premake - arena.c
+ * A region allocator; everything in it is freed at once.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <stdlib.h>
+#include "util.h"
+#include "arena.h"
+
+#define BLOCK_SIZE  (64 * 1024)
+
+/* Every allocation is rounded up to this, which is enough for any of the
+ * project structures (pointers, ints, unsigned) */
+#define ALIGNMENT   sizeof(void*)
+
+#define ROUND_UP(n)  (((n) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+#define HEADER_SIZE  ROUND_UP(sizeof(ArenaBlock))
+
+
+/************************************************************************
+ * Create a new, empty arena. No memory is reserved until the first
+ * allocation.
+ ***********************************************************************/
+
+Arena* arena_create()
+{
+	Arena* arena = ALLOCT(Arena);
+	arena->blocks = NULL;
+	return arena;
+}
+
+
+void arena_destroy(Arena* arena)
+{
+	ArenaBlock* block;
+
+	if (arena == NULL)
+		return;
+
+	block = arena->blocks;
+	while (block != NULL)
+	{
+		ArenaBlock* next = block->next;
+		free(block);
+		block = next;
+	}
+
+	free(arena);
+}
+
+
+/************************************************************************
+ * Carve out a piece of memory from the arena. It stays valid until the
+ * arena is destroyed; there is no way to free it individually.
+ ***********************************************************************/
+
+void* arena_alloc(Arena* arena, size_t size)
+{
+	ArenaBlock* block = arena->blocks;
+	char* ptr;
+
+	size = ROUND_UP(size);
+	if (block == NULL || block->used + size > block->size)
+	{
+		/* Requests too big for a normal block get a block of their own */
+		size_t blockSize = (size > BLOCK_SIZE) ? size : BLOCK_SIZE;
+		block = (ArenaBlock*)malloc(HEADER_SIZE + blockSize);
+		block->size = blockSize;
+		block->used = 0;
+
+		/* Keep filling the current block if the new one is a one-off */
+		if (arena->blocks != NULL && blockSize > BLOCK_SIZE)
+		{
+			block->next = arena->blocks->next;
+			arena->blocks->next = block;
+		}
+		else
+		{
+			block->next = arena->blocks;
+			arena->blocks = block;
+		}
+	}
+
+	ptr = (char*)block + HEADER_SIZE + block->used;
+	block->used += size;
+	return ptr;
+}
@@ -0,0 +1,32 @@
+/**********************************************************************
+ * Premake - arena.h
+ * A region allocator; everything in it is freed at once.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+typedef struct tagArenaBlock
+{
+	struct tagArenaBlock* next;
+	size_t size;
+	size_t used;
+} ArenaBlock;
+
+typedef struct tagArena
+{
+	ArenaBlock* blocks;
+} Arena;
+
+Arena* arena_create();
+void   arena_destroy(Arena* arena);
+void*  arena_alloc(Arena* arena, size_t size);
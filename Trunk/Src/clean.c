@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "premake.h"
+#include "state.h"
 
 static char buffer[8192];
 
@@ -47,6 +48,9 @@ int clean()
 	io_remove(path_join(prj_get_path(), prj_get_name(), "mdsx"));
 	io_remove(path_join(prj_get_path(), "make", "sh"));
 
+	/* What each package was last generated from */
+	io_remove(state_getfilename());
+
 	for (i = 0; i < prj_get_numpackages(); ++i)
 	{
 		char cwd[8192];
@@ -0,0 +1,284 @@
+/**********************************************************************
+ * Premake - dircache.c
+ * A cache of directory listings, kept between runs.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "premake.h"
+#include "hash.h"
+#include "dircache.h"
+
+static const char* FILE_HEADER = "premake dircache 1";
+
+static char*       my_filename = NULL;
+static Hash*       my_listings = NULL;
+static DirListing* my_pending  = NULL;
+
+static char* copyString(const char* str);
+static int   readLine(FILE* file, char* buffer, int size);
+
+
+/************************************************************************
+ * Start using a cache file, loading any listings saved by a previous
+ * run. A missing or unreadable file just starts an empty cache. With
+ * no file name, the cache is kept in memory only.
+ ***********************************************************************/
+
+int dircache_open(const char* filename)
+{
+	char buffer[8192];
+	FILE* file;
+
+	if (my_listings != NULL)
+		return 1;
+
+	my_listings = hash_create();
+	if (filename == NULL)
+		return 1;
+
+	my_filename = copyString(path_absolute(filename));
+	file = fopen(my_filename, "r");
+	if (file == NULL)
+		return 1;
+
+	if (!readLine(file, buffer, 8192) || !matches(buffer, FILE_HEADER))
+	{
+		fclose(file);
+		return 1;
+	}
+
+	while (readLine(file, buffer, 8192))
+	{
+		DirListing* listing;
+		char stamp[256];
+		int count, i;
+
+		if (!readLine(file, stamp, 256))
+			break;
+
+		listing = dircache_new(buffer, stamp);
+
+		if (!readLine(file, buffer, 8192))
+			break;
+		count = atoi(buffer);
+		for (i = 0; i < count && readLine(file, buffer, 8192); ++i)
+			dircache_add(listing, buffer + 2, buffer[0]);
+
+		if (i < count)
+		{
+			/* Truncated file; drop the partial listing */
+			dircache_discard(listing);
+			break;
+		}
+
+		listing->used = 0;
+		hash_insert(my_listings, listing->path, listing);
+	}
+
+	fclose(file);
+	return 1;
+}
+
+
+/************************************************************************
+ * Write out all of the listings used during this run and release the
+ * cache. Listings for directories that weren't visited are dropped.
+ ***********************************************************************/
+
+int dircache_close()
+{
+	FILE* file;
+	int i, j;
+
+	if (my_listings == NULL)
+		return 1;
+
+	file = (my_filename != NULL) ? fopen(my_filename, "w") : NULL;
+	if (file != NULL)
+		fprintf(file, "%s\n", FILE_HEADER);
+
+	for (i = 0; i < my_listings->numBuckets; ++i)
+	{
+		HashEntry* entry;
+		for (entry = my_listings->buckets[i]; entry != NULL; entry = entry->next)
+		{
+			DirListing* listing = (DirListing*)entry->value;
+			if (file != NULL && listing->used)
+			{
+				fprintf(file, "%s\n%s\n%d\n", listing->path, listing->stamp, listing->count);
+				for (j = 0; j < listing->count; ++j)
+					fprintf(file, "%c %s\n", listing->types[j], listing->names[j]);
+			}
+			dircache_discard(listing);
+		}
+	}
+
+	if (file != NULL)
+		fclose(file);
+	else if (my_filename != NULL)
+		printf("** Unable to write directory cache '%s'\n", my_filename);
+
+	hash_destroy(my_listings);
+	my_listings = NULL;
+	free(my_filename);
+	my_filename = NULL;
+	return 1;
+}
+
+
+int dircache_isopen()
+{
+	return (my_listings != NULL);
+}
+
+
+/************************************************************************
+ * Retrieve the listing for a directory, if one is cached and the
+ * directory hasn't changed since it was made. Safe to call from more
+ * than one thread, as the table is only changed by dircache_commit().
+ ***********************************************************************/
+
+DirListing* dircache_find(const char* path, const char* stamp)
+{
+	DirListing* listing = (DirListing*)hash_find(my_listings, path);
+	if (listing == NULL || !matches(listing->stamp, stamp))
+		return NULL;
+
+	listing->used = 1;
+	return listing;
+}
+
+
+/************************************************************************
+ * Build up a new listing
+ ***********************************************************************/
+
+DirListing* dircache_new(const char* path, const char* stamp)
+{
+	DirListing* listing = ALLOCT(DirListing);
+	listing->path  = copyString(path);
+	listing->stamp = copyString(stamp);
+	listing->count = 0;
+	listing->size  = 16;
+	listing->names = (char**)malloc(sizeof(char*) * listing->size);
+	listing->types = (char*)malloc(listing->size);
+	listing->used  = 1;
+	listing->next  = NULL;
+	return listing;
+}
+
+
+void dircache_add(DirListing* listing, const char* name, int type)
+{
+	if (listing->count == listing->size)
+	{
+		listing->size *= 2;
+		listing->names = (char**)realloc(listing->names, sizeof(char*) * listing->size);
+		listing->types = (char*)realloc(listing->types, listing->size);
+	}
+
+	listing->names[listing->count] = copyString(name);
+	listing->types[listing->count] = (char)type;
+	listing->count++;
+}
+
+
+void dircache_discard(DirListing* listing)
+{
+	int i;
+	for (i = 0; i < listing->count; ++i)
+		free(listing->names[i]);
+	free(listing->names);
+	free(listing->types);
+	free(listing->path);
+	free(listing->stamp);
+	free(listing);
+}
+
+
+/************************************************************************
+ * Queue a new listing to be added to the cache. A directory changed
+ * within the last couple of seconds may be changed again without its
+ * time stamp moving, so its listing is not kept. The caller must make
+ * sure only one thread stores at a time.
+ ***********************************************************************/
+
+void dircache_store(DirListing* listing, long changed)
+{
+	int i;
+
+	if (changed >= (long)time(NULL) - 2)
+	{
+		dircache_discard(listing);
+		return;
+	}
+
+	/* Names that would break the line-based file can't be cached */
+	for (i = 0; i < listing->count; ++i)
+	{
+		if (strchr(listing->names[i], '\n') != NULL || strchr(listing->names[i], '\r') != NULL)
+		{
+			dircache_discard(listing);
+			return;
+		}
+	}
+
+	listing->next = my_pending;
+	my_pending = listing;
+}
+
+
+/************************************************************************
+ * Move the queued listings into the cache, once no walk is running
+ ***********************************************************************/
+
+void dircache_commit()
+{
+	while (my_pending != NULL)
+	{
+		DirListing* listing = my_pending;
+		DirListing* existing = (DirListing*)hash_find(my_listings, listing->path);
+		my_pending = listing->next;
+
+		hash_insert(my_listings, listing->path, listing);
+		if (existing != NULL && existing != listing)
+			dircache_discard(existing);
+	}
+}
+
+
+static char* copyString(const char* str)
+{
+	char* copy = (char*)malloc(strlen(str) + 1);
+	strcpy(copy, str);
+	return copy;
+}
+
+
+static int readLine(FILE* file, char* buffer, int size)
+{
+	int len;
+
+	if (fgets(buffer, size, file) == NULL)
+		return 0;
+
+	len = strlen(buffer);
+	while (len > 0 && (buffer[len - 1] == '\n' || buffer[len - 1] == '\r'))
+		buffer[--len] = '\0';
+	return 1;
+}
@@ -0,0 +1,40 @@
+/**********************************************************************
+ * Premake - dircache.h
+ * A cache of directory listings, kept between runs.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+enum { DC_FILE = 'f', DC_DIR = 'd' };
+
+typedef struct tagDirListing
+{
+	char*  path;
+	char*  stamp;
+	char** names;
+	char*  types;
+	int    count;
+	int    size;
+	int    used;
+	struct tagDirListing* next;
+} DirListing;
+
+int          dircache_open(const char* filename);
+int          dircache_close();
+int          dircache_isopen();
+DirListing*  dircache_find(const char* path, const char* stamp);
+DirListing*  dircache_new(const char* path, const char* stamp);
+void         dircache_add(DirListing* listing, const char* name, int type);
+void         dircache_discard(DirListing* listing);
+void         dircache_store(DirListing* listing, long changed);
+void         dircache_commit();
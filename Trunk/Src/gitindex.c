@@ -0,0 +1,403 @@
+/**********************************************************************
+ * Premake - gitindex.c
+ * A reader for the list of files tracked by a Git work tree.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "premake.h"
+#include "platform.h"
+#include "gitindex.h"
+
+/* Entry mode bits, and the flags that take an entry out of the list */
+#define MODE_TYPE_MASK      0170000
+#define MODE_FILE           0100000
+#define MODE_SYMLINK        0120000
+#define ENTRY_EXTENDED      0x4000
+#define ENTRY_NAME_MASK     0x0FFF
+#define ENTRY_SKIP_WORKTREE 0x4000
+
+static GitIndex* my_indexes = NULL;
+
+static int      findGitDir(const char* dir, char* gitdir);
+static int      hashSize(const char* gitdir);
+static int      load(GitIndex* index);
+static unsigned readInt(const unsigned char* ptr, int size);
+static unsigned readVarInt(const unsigned char** ptr);
+
+
+/************************************************************************
+ * Locate the Git work tree containing a directory, and return a list of
+ * the files tracked in it. The index is read again whenever the Git
+ * directory has changed since it was last read. Returns NULL if there
+ * is no work tree, or if its index can't be read.
+ ***********************************************************************/
+
+GitIndex* gitindex_find(const char* path)
+{
+	GitIndex* index;
+	char dir[8192];
+	char gitdir[8192];
+	char stamp[256];
+	char* sep;
+	long changed;
+	int  len;
+
+	strcpy(dir, path);
+	len = strlen(dir);
+	if (len > 1 && dir[len - 1] == '/')
+		dir[len - 1] = '\0';
+
+	while (!findGitDir(dir, gitdir))
+	{
+		sep = strrchr(dir, '/');
+		if (sep == NULL || (sep == dir && dir[1] == '\0'))
+			return NULL;
+		if (sep == dir)
+			sep[1] = '\0';
+		else
+			sep[0] = '\0';
+	}
+
+	if (!platform_dirstamp(gitdir, stamp, &changed))
+		return NULL;
+
+	for (index = my_indexes; index != NULL; index = index->next)
+	{
+		if (matches(index->worktree, dir))
+			break;
+	}
+
+	if (index == NULL)
+	{
+		index = ALLOCT(GitIndex);
+		index->worktree = (char*)malloc(strlen(dir) + 1);
+		strcpy(index->worktree, dir);
+		index->gitdir  = NULL;
+		index->stamp[0] = '\0';
+		index->strings = NULL;
+		index->paths   = NULL;
+		index->count   = -1;
+		index->next    = my_indexes;
+		my_indexes = index;
+	}
+
+	if (index->count < 0 || !matches(index->stamp, stamp) || !matches(index->gitdir, gitdir))
+	{
+		free(index->gitdir);
+		index->gitdir = (char*)malloc(strlen(gitdir) + 1);
+		strcpy(index->gitdir, gitdir);
+		strcpy(index->stamp, stamp);
+		if (!load(index))
+			index->count = -1;
+	}
+
+	return (index->count >= 0) ? index : NULL;
+}
+
+
+/************************************************************************
+ * Return the position of the first tracked path that sorts at or after
+ * the given one. Paths are relative to the work tree, and sorted the
+ * same way Git sorts them.
+ ***********************************************************************/
+
+int gitindex_first(GitIndex* index, const char* prefix)
+{
+	int lo = 0;
+	int hi = index->count;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (strcmp(index->paths[mid], prefix) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+
+int gitindex_contains(GitIndex* index, const char* path)
+{
+	int i = gitindex_first(index, path);
+	return (i < index->count && matches(index->paths[i], path));
+}
+
+
+void gitindex_close()
+{
+	while (my_indexes != NULL)
+	{
+		GitIndex* index = my_indexes;
+		my_indexes = index->next;
+		free(index->worktree);
+		free(index->gitdir);
+		free(index->strings);
+		free(index->paths);
+		free(index);
+	}
+}
+
+
+/************************************************************************
+ * A work tree has a .git directory, or a .git file pointing at one
+ * somewhere else, as for linked work trees and submodules
+ ***********************************************************************/
+
+static int findGitDir(const char* dir, char* gitdir)
+{
+	FILE* file;
+	char  buffer[8192];
+	char  stamp[256];
+	long  changed;
+	int   len;
+
+	strcpy(gitdir, dir);
+	if (gitdir[strlen(gitdir) - 1] != '/')
+		strcat(gitdir, "/");
+	strcat(gitdir, ".git");
+
+	if (platform_dirstamp(gitdir, stamp, &changed))
+		return 1;
+
+	file = fopen(gitdir, "r");
+	if (file == NULL)
+		return 0;
+
+	len = 0;
+	if (fgets(buffer, 8192, file) != NULL)
+		len = strlen(buffer);
+	fclose(file);
+
+	while (len > 0 && (buffer[len - 1] == '\n' || buffer[len - 1] == '\r' || buffer[len - 1] == ' '))
+		buffer[--len] = '\0';
+
+	if (strncmp(buffer, "gitdir: ", 8) != 0)
+		return 0;
+
+	if (platform_isAbsolutePath(buffer + 8))
+	{
+		strcpy(gitdir, buffer + 8);
+	}
+	else
+	{
+		strcpy(gitdir, dir);
+		if (gitdir[strlen(gitdir) - 1] != '/')
+			strcat(gitdir, "/");
+		strcat(gitdir, buffer + 8);
+	}
+
+	return 1;
+}
+
+
+/************************************************************************
+ * Read the index file. Versions 2 through 4 are understood; anything
+ * else, including a split index, fails and the caller falls back to
+ * searching the file system.
+ ***********************************************************************/
+
+static int load(GitIndex* index)
+{
+	FILE* file;
+	unsigned char* data;
+	const unsigned char* ptr;
+	const unsigned char* end;
+	char  path[8192];
+	char* strings;
+	int   size, version, count, oidSize, pathLen, numStrings, i;
+
+	free(index->strings);
+	free(index->paths);
+	index->strings = NULL;
+	index->paths   = NULL;
+	index->count   = 0;
+
+	sprintf(path, "%s/index", index->gitdir);
+	file = fopen(path, "rb");
+	if (file == NULL)
+		return 0;
+
+	fseek(file, 0, SEEK_END);
+	size = (int)ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	data = (unsigned char*)malloc(size > 0 ? size : 1);
+	if (size < 12 || (int)fread(data, 1, size, file) != size || memcmp(data, "DIRC", 4) != 0)
+	{
+		fclose(file);
+		free(data);
+		return 0;
+	}
+	fclose(file);
+
+	version = readInt(data + 4, 4);
+	count   = readInt(data + 8, 4);
+	oidSize = hashSize(index->gitdir);
+	if (version < 2 || version > 4 || size < 12 + oidSize)
+	{
+		free(data);
+		return 0;
+	}
+
+	/* No path can be longer than the file it came from, so the whole
+	 * file is enough to hold all of the strings */
+	index->strings = (char*)malloc(size);
+	index->paths   = (char**)malloc(sizeof(char*) * (count > 0 ? count : 1));
+	strings = index->strings;
+	numStrings = 0;
+
+	ptr = data + 12;
+	end = data + size - oidSize;
+	pathLen = 0;
+	for (i = 0; i < count; ++i)
+	{
+		const unsigned char* name;
+		unsigned mode, flags, xflags;
+		int nameLen;
+
+		if (ptr + 42 + oidSize > end)
+			break;
+
+		mode  = readInt(ptr + 24, 4);
+		flags = readInt(ptr + 40 + oidSize, 2);
+		name  = ptr + 42 + oidSize;
+
+		xflags = 0;
+		if (flags & ENTRY_EXTENDED)
+		{
+			if (version < 3)
+				break;
+			xflags = readInt(name, 2);
+			name += 2;
+		}
+
+		if (version == 4)
+		{
+			/* Each path drops some bytes from the end of the one before,
+			 * then adds a new suffix */
+			unsigned strip = readVarInt(&name);
+			nameLen = 0;
+			while (name + nameLen < end && name[nameLen] != '\0')
+				nameLen++;
+			if ((int)strip > pathLen || name + nameLen >= end || pathLen - (int)strip + nameLen >= 8192)
+				break;
+			pathLen -= strip;
+			memcpy(path + pathLen, name, nameLen);
+			pathLen += nameLen;
+			path[pathLen] = '\0';
+			ptr = name + nameLen + 1;
+		}
+		else
+		{
+			/* Entries are padded with one to eight nulls, out to a multiple
+			 * of eight bytes */
+			nameLen = flags & ENTRY_NAME_MASK;
+			if (nameLen == ENTRY_NAME_MASK)
+			{
+				while (name + nameLen < end && name[nameLen] != '\0')
+					nameLen++;
+			}
+			if (name + nameLen >= end || nameLen >= 8192)
+				break;
+			memcpy(path, name, nameLen);
+			pathLen = nameLen;
+			path[pathLen] = '\0';
+			ptr += ((name - ptr) + nameLen + 8) & ~7;
+		}
+
+		/* Keep regular files and links that are checked out. Submodules,
+		 * sparse directories, and files outside of a sparse checkout are
+		 * left out, and a conflicted file is listed once, not per stage. */
+		if ((mode & MODE_TYPE_MASK) != MODE_FILE && (mode & MODE_TYPE_MASK) != MODE_SYMLINK)
+			continue;
+		if (xflags & ENTRY_SKIP_WORKTREE)
+			continue;
+		if (numStrings > 0 && matches(index->paths[numStrings - 1], path))
+			continue;
+
+		strcpy(strings, path);
+		index->paths[numStrings++] = strings;
+		strings += pathLen + 1;
+	}
+
+	/* A split index keeps most of its entries in another file */
+	while (i == count && ptr + 8 <= end)
+	{
+		unsigned extSize = readInt(ptr + 4, 4);
+		if (memcmp(ptr, "link", 4) == 0 || extSize > (unsigned)(end - ptr - 8))
+		{
+			i = -1;
+			break;
+		}
+		ptr += 8 + extSize;
+	}
+
+	free(data);
+	if (i != count)
+		return 0;
+
+	index->count = numStrings;
+	return 1;
+}
+
+
+/* Repositories using SHA-256 say so in their config */
+static int hashSize(const char* gitdir)
+{
+	FILE* file;
+	char  buffer[8192];
+	int   size = 20;
+
+	sprintf(buffer, "%s/config", gitdir);
+	file = fopen(buffer, "r");
+	if (file == NULL)
+		return size;
+
+	while (fgets(buffer, 8192, file) != NULL)
+	{
+		if (strstr(buffer, "objectformat") != NULL && strstr(buffer, "sha256") != NULL)
+			size = 32;
+	}
+
+	fclose(file);
+	return size;
+}
+
+
+static unsigned readInt(const unsigned char* ptr, int size)
+{
+	unsigned value = 0;
+	int i;
+	for (i = 0; i < size; ++i)
+		value = (value << 8) | ptr[i];
+	return value;
+}
+
+
+static unsigned readVarInt(const unsigned char** ptr)
+{
+	const unsigned char* p = *ptr;
+	unsigned value = *p & 127;
+	while (*p & 128)
+	{
+		p++;
+		value = ((value + 1) << 7) | (*p & 127);
+	}
+	*ptr = p + 1;
+	return value;
+}
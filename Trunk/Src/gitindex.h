@@ -0,0 +1,32 @@
+/**********************************************************************
+ * Premake - gitindex.h
+ * A reader for the list of files tracked by a Git work tree.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+typedef struct tagGitIndex
+{
+	char*  worktree;
+	char*  gitdir;
+	char   stamp[256];
+	char*  strings;
+	char** paths;
+	int    count;
+	struct tagGitIndex* next;
+} GitIndex;
+
+GitIndex* gitindex_find(const char* path);
+int       gitindex_first(GitIndex* index, const char* prefix);
+int       gitindex_contains(GitIndex* index, const char* path);
+void      gitindex_close();
@@ -20,47 +20,47 @@
 #include "premake.h"
 #include "arg.h"
 #include "gnu.h"
+#include "state.h"
 
+static int writePackage(int i);
 static int writeRootMakefile();
 static const char* listInterPackageDeps(const char* name);
 
 
 int gnu_generate()
 {
-	int i;
-
 	puts("Generating GNU makefiles:");
 
-	if (!writeRootMakefile())
+	/* Package makefiles don't depend on each other, and may be written
+	 * in parallel (--jobs); the root makefile is written once they are
+	 * all done */
+	if (!state_run(prj_get_numpackages(), writePackage))
 		return 0;
 
-	for (i = 0; i < prj_get_numpackages(); ++i)
-	{
-		int result;
+	return writeRootMakefile();
+}
 
-		prj_select_package(i);
 
-		printf("...%s\n", prj_get_pkgname());
+static int writePackage(int i)
+{
+	prj_select_package(i);
+	prj_select_config(0);
 
-		if (prj_is_lang("c#"))
-		{
-			result = gnu_cs();
-		}
-		else if (prj_is_lang("c++") || prj_is_lang("c"))
-		{
-			result = gnu_cpp();
-		}
-		else
-		{
-			printf("** Error: unrecognized language '%s'\n", prj_get_language());
-			return 0;
-		}
+	printf("...%s\n", prj_get_pkgname());
 
-		if (!result)
-			return 0;
+	if (prj_is_lang("c#"))
+	{
+		return gnu_cs();
+	}
+	else if (prj_is_lang("c++") || prj_is_lang("c"))
+	{
+		return gnu_cpp();
+	}
+	else
+	{
+		printf("** Error: unrecognized language '%s'\n", prj_get_language());
+		return 0;
 	}
-
-	return 1;
 }
 
 
@@ -136,6 +136,29 @@ static int writeRootMakefile()
 		{
 			arg_getflagarg();
 		}
+		else if (matches(arg, "--jobs") || matches(arg, "--threads"))
+		{
+			/* Left out so the output doesn't depend on the job count */
+			arg_getflagarg();
+		}
+		else if (matches(arg, "--gitindex") || matches(arg, "--include-untracked"))
+		{
+			/* Search options are left out too, like the job count */
+		}
+		else if (matches(arg, "--from-model") || matches(arg, "--save-model"))
+		{
+			/* Regenerating always reruns the script */
+			arg_getflagarg();
+		}
+		else if (matches(arg, "--dircache"))
+		{
+			/* The cache belongs to the run that made it */
+			arg_getflagarg();
+		}
+		else if (matches(arg, "--watch"))
+		{
+			/* make would never get control back */
+		}
 		else
 		{
 			io_print(" %s", arg);
@@ -174,8 +197,7 @@ static int writeRootMakefile()
 		io_print(" clean\n");
 	}
 	
-	io_closefile();
-	return 1;
+	return io_closefile();
 }
 
 
@@ -186,13 +208,7 @@ static int writeRootMakefile()
 
 static const char* listInterPackageDeps(const char* name)
 {
-	int i;
-	for (i = 0; i < prj_get_numpackages(); ++i)
-	{
-		if (matches(name, prj_get_pkgname_for(i)))
-			return name;
-	}
-	return NULL;
+	return (prj_find_package(name) >= 0) ? name : NULL;
 }
 
 
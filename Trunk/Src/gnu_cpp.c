@@ -16,10 +16,12 @@
  **********************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "premake.h"
 #include "gnu.h"
 #include "os.h"
+#include "hash.h"
 
 static const char* filterLinks(const char* name);
 static const char* listCppSources(const char* name);
@@ -27,11 +29,14 @@ static const char* listRcSources(const char* name);
 static const char* listCppTargets(const char* name);
 static const char* listRcTargets(const char* name);
 static const char* listLinkerDeps(const char* name);
+static void printFileLists(const char* indent);
+static const char** listAllFiles();
 
 
 int gnu_cpp()
 {
-	int i;
+	const char** files;
+	int i, shared;
 
 	const char* prefix = (g_verbose) ? "" : "@";
 
@@ -63,6 +68,7 @@ int gnu_cpp()
 	io_print("endif\n\n");
 
 	/* Process the build configurations */
+	shared = prj_has_shared_files();
 	for (i = 0; i < prj_get_numconfigs(); ++i)
 	{
 		prj_select_config(i);
@@ -86,28 +92,28 @@ int gnu_cpp()
 		io_print("  CFLAGS += $(CPPFLAGS)");
 		if (prj_is_kind("dll") && !os_is("windows"))
 			io_print(" -fPIC");
-		if (!prj_has_flag("no-symbols"))
+		if (!prj_has_flag(FLAG_NO_SYMBOLS))
 			io_print(" -g");
-		if (prj_has_flag("optimize-size"))
+		if (prj_has_flag(FLAG_OPTIMIZE_SIZE))
 			io_print(" -Os");
-		if (prj_has_flag("optimize-speed"))
+		if (prj_has_flag(FLAG_OPTIMIZE_SPEED))
 			io_print(" -O3");
-		if (prj_has_flag("optimize") && !prj_has_flag("optimize-size") && !prj_has_flag("optimize-speed"))
+		if (prj_has_flag(FLAG_OPTIMIZE) && !prj_has_flag(FLAG_OPTIMIZE_SIZE) && !prj_has_flag(FLAG_OPTIMIZE_SPEED))
 			io_print(" -O2");
-		if (prj_has_flag("extra-warnings"))
+		if (prj_has_flag(FLAG_EXTRA_WARNINGS))
 			io_print(" -Wall");
-		if (prj_has_flag("fatal-warnings"))
+		if (prj_has_flag(FLAG_FATAL_WARNINGS))
 			io_print(" -Werror");
-		if (prj_has_flag("no-frame-pointer"))
+		if (prj_has_flag(FLAG_NO_FRAME_POINTER))
 			io_print(" -fomit-frame-pointer");
 		print_list(prj_get_buildoptions(), " ", "", "", NULL);
 		io_print("\n");
 
 		/* Write C++ flags */
 		io_print("  CXXFLAGS := $(CFLAGS)");
-		if (prj_has_flag("no-exceptions"))
+		if (prj_has_flag(FLAG_NO_EXCEPTIONS))
 			io_print(" --no-exceptions");
-		if (prj_has_flag("no-rtti"))
+		if (prj_has_flag(FLAG_NO_RTTI))
 			io_print(" --no-rtti");
 		io_print("\n");
 
@@ -115,9 +121,9 @@ int gnu_cpp()
 		io_print("  LDFLAGS += -L$(BINDIR) -L$(LIBDIR)");
 		if (prj_is_kind("dll") && (g_cc == NULL || matches(g_cc, "gcc")))
 			io_print(" -shared");
-		if (prj_has_flag("no-symbols"))
+		if (prj_has_flag(FLAG_NO_SYMBOLS))
 			io_print(" -s");
-		if (os_is("macosx") && prj_has_flag("dylib"))
+		if (os_is("macosx") && prj_has_flag(FLAG_DYLIB))
 			io_print(" -dynamiclib -flat_namespace");
 		print_list(prj_get_linkoptions(), " ", "", "", NULL);
 		print_list(prj_get_libpaths(), " -L \"", "\"", "", NULL);
@@ -142,21 +148,16 @@ int gnu_cpp()
 			io_print("$(%s) -o $(OUTDIR)/$(TARGET) $(OBJECTS) $(LDFLAGS) $(RESOURCES)", prj_is_lang("c") ? "CC" : "CXX");
 		io_print("\n");
 
+		/* Configurations that build different files list them here */
+		if (!shared)
+			printFileLists("  ");
+
 		io_print("endif\n\n");
 	}
 
-	/* Write out the list of object file targets for all C/C++ sources */
-	io_print("OBJECTS := \\\n");
-	print_list(prj_get_files(), "\t$(OBJDIR)/", " \\\n", "", listCppSources);
-	io_print("\n");
-
-	/* Write out the list of resource files for windows targets */
-	if (os_is("windows"))
-	{
-		io_print("RESOURCES := \\\n");
-		print_list(prj_get_files(), "\t$(OBJDIR)/", " \\\n", "", listRcSources);
-		io_print("\n");
-	}
+	/* Otherwise the list is the same everywhere and written once */
+	if (shared)
+		printFileLists("");
 
 	io_print("CMD := $(subst \\,\\\\,$(ComSpec)$(COMSPEC))\n");
 	io_print("ifeq (,$(CMD))\n");
@@ -233,19 +234,83 @@ int gnu_cpp()
 	 * fine but made it more difficult to test and also required the use of
 	 * VPATH which I didn't like. This new approach of listing each file
 	 * helps testing and opens the way for per-file configurations */
-	print_list(prj_get_files(), "", "\n", "", listCppTargets);
+	files = listAllFiles();
+	print_list(files, "", "\n", "", listCppTargets);
 	
 	if (os_is("windows"))
-		print_list(prj_get_files(), "", "", "", listRcTargets);
+		print_list(files, "", "", "", listRcTargets);
+
+	if (files != prj_get_files())
+		free((void*)files);
 
 	/* Include the automatically generated dependency lists */
 	io_print("-include $(OBJECTS:%%.o=%%.d)\n\n");
 
-	io_closefile();
-	return 1;
+	return io_closefile();
+}
+
+
+
+/************************************************************************
+ * Writes the lists of object files and resources built by the active
+ * configuration
+ ***********************************************************************/
+
+static void printFileLists(const char* indent)
+{
+	/* Write out the list of object file targets for all C/C++ sources */
+	io_print("%sOBJECTS := \\\n", indent);
+	print_list(prj_get_files(), "\t$(OBJDIR)/", " \\\n", "", listCppSources);
+	io_print("\n");
+
+	/* Write out the list of resource files for windows targets */
+	if (os_is("windows"))
+	{
+		io_print("%sRESOURCES := \\\n", indent);
+		print_list(prj_get_files(), "\t$(OBJDIR)/", " \\\n", "", listRcSources);
+		io_print("\n");
+	}
 }
 
 
+/************************************************************************
+ * Returns every file built by any configuration of the package, in the
+ * order they are first listed. When all of the configurations build the
+ * same files this is the active list, otherwise it must be freed
+ ***********************************************************************/
+
+static const char** listAllFiles()
+{
+	PkgConfig** configs = prj_get_package()->configs;
+	const char** files;
+	Hash* seen;
+	int count, i, j;
+
+	if (prj_has_shared_files())
+		return prj_get_files();
+
+	count = 0;
+	for (i = 0; i < prj_get_numconfigs(); ++i)
+		count += prj_getlistsize((void**)configs[i]->files);
+
+	files = (const char**)malloc(sizeof(const char*) * (count + 1));
+	seen = hash_create();
+	count = 0;
+	for (i = 0; i < prj_get_numconfigs(); ++i)
+	{
+		const char** list = configs[i]->files;
+		for (j = 0; list[j] != NULL; ++j)
+		{
+			if (hash_insert(seen, list[j], (void*)list[j]))
+				files[count++] = list[j];
+		}
+	}
+	files[count] = NULL;
+
+	hash_destroy(seen);
+	return files;
+}
+
 
 /************************************************************************
  * Checks each entry in the list of package links. If the entry refers
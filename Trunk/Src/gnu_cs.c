@@ -20,12 +20,11 @@
 #include "premake.h"
 #include "gnu.h"
 #include "os.h"
+#include "platform.h"
 
-static char buffer[8192];
+static THREAD_LOCAL char buffer[8192];
 
-static const char* assignCodeFiles(const char* name);
-static const char* assignEmbeddedFiles(const char* name);
-static const char* assignContentFiles(const char* name);
+static int         isBuildAction(const char* name, const char* action);
 
 static const char* listCodeFiles(const char* name);
 static const char* listEmbeddedFiles(const char* name);
@@ -153,21 +152,21 @@ int gnu_cs()
 		io_print("  OUTDIR := %s\n", prj_get_outdir());
 
 		io_print("  FLAGS += /t:%s", kind);
-		if (!prj_has_flag("no-symbols"))
+		if (!prj_has_flag(FLAG_NO_SYMBOLS))
 		{
 			io_print(" /debug");
 		}
-		if (prj_has_flag("optimize") || prj_has_flag("optimize-size") || prj_has_flag("optimize-speed"))
+		if (prj_has_flag(FLAG_OPTIMIZE) || prj_has_flag(FLAG_OPTIMIZE_SIZE) || prj_has_flag(FLAG_OPTIMIZE_SPEED))
 		{
 			/* Mono doesn't support the optimize flag */
 			if (!matches(csc, "mcs"))
 				io_print(" /optimize");
 		}
-		if (prj_has_flag("unsafe"))
+		if (prj_has_flag(FLAG_UNSAFE))
 		{
 			io_print(" /unsafe");
 		}
-		if (prj_has_flag("fatal-warnings"))
+		if (prj_has_flag(FLAG_FATAL_WARNINGS))
 		{
 			io_print(" /warnaserror");
 		}
@@ -194,12 +193,6 @@ int gnu_cs()
 		io_print("endif\n\n");
 	}
 
-	/* Sort out the files by build action...start by assigning build actions
-	 * to well-known file extensions...these don't write anything to the file */
-	print_list(prj_get_files(), "", "", "", assignCodeFiles);
-	print_list(prj_get_files(), "", "", "", assignEmbeddedFiles);
-	print_list(prj_get_files(), "", "", "", assignContentFiles);
-
 	/* Sort out the files by build action */
 	io_print("SOURCES := \\\n");
 	print_list(prj_get_files(), "\t", " \\\n", "", listCodeFiles);
@@ -269,8 +262,7 @@ int gnu_cs()
 	/* Resource build targets */
 	print_list(prj_get_files(), "", "", "", listResourceBuildSteps);
 
-	io_closefile();
-	return 1;
+	return io_closefile();
 }
 
 
@@ -321,34 +313,26 @@ static const char* makeVsNetCompatName(const char* name)
 
 
 /************************************************************************
- * Assign default build actions to files without one
+ * Files without a build action get a default one from their extension.
+ * The model is shared with the other generators, so it isn't changed
  ***********************************************************************/
 
-static const char* assignCodeFiles(const char* name)
+static int isBuildAction(const char* name, const char* action)
 {
-	const char* ext = path_getextension(name);
-	prj_select_file(name);
-	if (prj_is_buildaction(NULL) && matches(ext, ".cs"))
-		prj_set_buildaction("Code");
-	return NULL;
-}
+	const char* ext;
 
-static const char* assignEmbeddedFiles(const char* name)
-{
-	const char* ext = path_getextension(name);
 	prj_select_file(name);
-	if (prj_is_buildaction(NULL) && matches(ext, ".resx"))
-		prj_set_buildaction("EmbeddedResource");
-	return NULL;
-}
-
-static const char* assignContentFiles(const char* name)
-{
-	const char* ext = path_getextension(name);
-	prj_select_file(name);
-	if (prj_is_buildaction(NULL) && (matches(ext, ".asax") || matches(ext, ".aspx")))
-		prj_set_buildaction("Content");
-	return NULL;
+	if (!prj_is_buildaction(NULL))
+		return prj_is_buildaction(action);
+
+	ext = path_getextension(name);
+	if (matches(ext, ".cs"))
+		return matches(action, "Code");
+	if (matches(ext, ".resx"))
+		return matches(action, "EmbeddedResource");
+	if (matches(ext, ".asax") || matches(ext, ".aspx"))
+		return matches(action, "Content");
+	return 0;
 }
 
 
@@ -360,27 +344,21 @@ static const char* assignContentFiles(const char* name)
 static const char* findLocalAssembly(const char* name)
 {
 	const char** paths;
-	const char*  result = NULL;
-
-	/* Lib paths are relative to package directory. Have to make package
-	 * directory current for io_fileexists() to work */
-	strcpy(buffer, io_getcwd());
-	io_chdir(prj_get_pkgpath());
 
+	/* Lib paths are relative to the package directory */
 	paths = prj_get_libpaths();
 	while (*paths != NULL)
 	{
 		const char* path = path_join(*paths, name, "dll");
-		if (io_fileexists(path))
-		{
-			result = path;
-			break;
-		}
+		const char* full = path;
+		if (!platform_isAbsolutePath(path))
+			full = path_combine_r(prj_get_pkgpath(), path, buffer);
+		if (io_fileexists(full))
+			return path;
 		++paths;
 	}
 
-	io_chdir(buffer);
-	return result;
+	return NULL;
 }
 
 
@@ -390,8 +368,7 @@ static const char* findLocalAssembly(const char* name)
 
 static const char* listCodeFiles(const char* name)
 {
-	prj_select_file(name);
-	if (prj_is_buildaction("Code"))
+	if (isBuildAction(name, "Code"))
 	{
 		/* Csc needs backslashes, which GNU make doesn't like */
 		const char* src = path_translate(name, NULL);
@@ -420,8 +397,7 @@ static const char* listCodeFiles(const char* name)
 
 static const char* listEmbeddedFiles(const char* name)
 {
-	prj_select_file(name);
-	if (prj_is_buildaction("EmbeddedResource"))
+	if (isBuildAction(name, "EmbeddedResource"))
 		return makeVsNetCompatName(name);
 	else
 		return NULL;
@@ -429,8 +405,7 @@ static const char* listEmbeddedFiles(const char* name)
 
 static const char* listLinkedFiles(const char* name)
 {
-	prj_select_file(name);
-	if (prj_is_buildaction("LinkedResource"))
+	if (isBuildAction(name, "LinkedResource"))
 		return makeVsNetCompatName(name);
 	else
 		return NULL;
@@ -438,8 +413,7 @@ static const char* listLinkedFiles(const char* name)
 
 static const char* listContentFiles(const char* name)
 {
-	prj_select_file(name);
-	if (prj_is_buildaction("Content"))
+	if (isBuildAction(name, "Content"))
 		return name;
 	else
 		return NULL;
@@ -513,8 +487,7 @@ static const char* listReferenceDeps(const char* name)
 
 static const char* listContentTargets(const char* name)
 {
-	prj_select_file(name);
-	if (prj_is_buildaction("LinkedResource") || prj_is_buildaction("Content"))
+	if (isBuildAction(name, "LinkedResource") || isBuildAction(name, "Content"))
 	{
 		sprintf(buffer, "$(BINDIR)/%s", path_getname(name));
 		return buffer;
@@ -532,8 +505,7 @@ static const char* listContentTargets(const char* name)
 
 static const char* listContentRules(const char* name)
 {
-	prj_select_file(name);
-	if (prj_is_buildaction("LinkedResource") || prj_is_buildaction("Content"))
+	if (isBuildAction(name, "LinkedResource") || isBuildAction(name, "Content"))
 	{
 		sprintf(buffer, "$(BINDIR)/%s: %s\n\t-@cp -fR $^ $@\n\n", path_getname(name), name);
 		return buffer;
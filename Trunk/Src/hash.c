@@ -0,0 +1,154 @@
+/**********************************************************************
+ * Premake - hash.c
+ * A string-keyed hash table.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "util.h"
+#include "hash.h"
+
+static void grow(Hash* hash);
+
+
+/************************************************************************
+ * Create a new, empty table. Keys are not copied; they must stay valid
+ * for as long as the table is in use.
+ ***********************************************************************/
+
+Hash* hash_create()
+{
+	Hash* hash = ALLOCT(Hash);
+	hash->numBuckets = 16;
+	hash->count = 0;
+	hash->buckets = (HashEntry**)calloc(hash->numBuckets, sizeof(HashEntry*));
+	return hash;
+}
+
+
+void hash_destroy(Hash* hash)
+{
+	int i;
+
+	if (hash == NULL)
+		return;
+
+	for (i = 0; i < hash->numBuckets; ++i)
+	{
+		HashEntry* entry = hash->buckets[i];
+		while (entry != NULL)
+		{
+			HashEntry* next = entry->next;
+			free(entry);
+			entry = next;
+		}
+	}
+
+	free(hash->buckets);
+	free(hash);
+}
+
+
+/************************************************************************
+ * Look up a key, returning the stored value or NULL
+ ***********************************************************************/
+
+void* hash_find(Hash* hash, const char* key)
+{
+	unsigned code = hash_string(key);
+	HashEntry* entry = hash->buckets[code & (hash->numBuckets - 1)];
+	while (entry != NULL)
+	{
+		if (entry->code == code && strcmp(entry->key, key) == 0)
+			return entry->value;
+		entry = entry->next;
+	}
+	return NULL;
+}
+
+
+/************************************************************************
+ * Store a value under a key, replacing any existing value. Returns
+ * zero if the key was already present.
+ ***********************************************************************/
+
+int hash_insert(Hash* hash, const char* key, void* value)
+{
+	unsigned code = hash_string(key);
+	HashEntry* entry = hash->buckets[code & (hash->numBuckets - 1)];
+	while (entry != NULL)
+	{
+		if (entry->code == code && strcmp(entry->key, key) == 0)
+		{
+			entry->key   = key;
+			entry->value = value;
+			return 0;
+		}
+		entry = entry->next;
+	}
+
+	if (hash->count >= hash->numBuckets)
+		grow(hash);
+
+	entry = ALLOCT(HashEntry);
+	entry->key   = key;
+	entry->value = value;
+	entry->code  = code;
+	entry->next  = hash->buckets[code & (hash->numBuckets - 1)];
+	hash->buckets[code & (hash->numBuckets - 1)] = entry;
+	hash->count++;
+	return 1;
+}
+
+
+/************************************************************************
+ * FNV-1a string hash
+ ***********************************************************************/
+
+unsigned hash_string(const char* str)
+{
+	unsigned code = 2166136261u;
+	while (*str != '\0')
+	{
+		code ^= (unsigned char)*str++;
+		code *= 16777619u;
+	}
+	return code;
+}
+
+
+static void grow(Hash* hash)
+{
+	HashEntry** buckets;
+	int numBuckets, i;
+
+	numBuckets = hash->numBuckets * 2;
+	buckets = (HashEntry**)calloc(numBuckets, sizeof(HashEntry*));
+	for (i = 0; i < hash->numBuckets; ++i)
+	{
+		HashEntry* entry = hash->buckets[i];
+		while (entry != NULL)
+		{
+			HashEntry* next = entry->next;
+			entry->next = buckets[entry->code & (numBuckets - 1)];
+			buckets[entry->code & (numBuckets - 1)] = entry;
+			entry = next;
+		}
+	}
+
+	free(hash->buckets);
+	hash->buckets = buckets;
+	hash->numBuckets = numBuckets;
+}
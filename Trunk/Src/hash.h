@@ -0,0 +1,37 @@
+/**********************************************************************
+ * Premake - hash.h
+ * A string-keyed hash table.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+typedef struct tagHashEntry
+{
+	const char* key;
+	void*       value;
+	unsigned    code;
+	struct tagHashEntry* next;
+} HashEntry;
+
+typedef struct tagHash
+{
+	HashEntry** buckets;
+	int         numBuckets;
+	int         count;
+} Hash;
+
+Hash*        hash_create();
+void         hash_destroy(Hash* hash);
+void*        hash_find(Hash* hash, const char* key);
+int          hash_insert(Hash* hash, const char* key, void* value);
+unsigned     hash_string(const char* str);
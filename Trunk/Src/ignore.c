@@ -0,0 +1,215 @@
+/**********************************************************************
+ * Premake - ignore.c
+ * Ignore rules that prune file searches.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "premake.h"
+#include "match.h"
+#include "ignore.h"
+
+/* Version control metadata is never searched, unless a rule says so */
+static const char* DEFAULT_RULES[] = { ".bzr/", ".git/", ".hg/", ".svn/", "CVS/", NULL };
+
+static IgnoreList* my_defaults = NULL;
+
+static void addRule(IgnoreList* list, const char* line);
+static int  testList(IgnoreList* list, const char* path, int isdir);
+
+
+/************************************************************************
+ * Return the built-in rules, which are checked before any ignore file
+ ***********************************************************************/
+
+IgnoreList* ignore_defaults()
+{
+	int i;
+
+	if (my_defaults == NULL)
+	{
+		my_defaults = ALLOCT(IgnoreList);
+		my_defaults->dir    = "";
+		my_defaults->rules  = NULL;
+		my_defaults->count  = 0;
+		my_defaults->parent = NULL;
+		for (i = 0; DEFAULT_RULES[i] != NULL; ++i)
+			addRule(my_defaults, DEFAULT_RULES[i]);
+	}
+
+	return my_defaults;
+}
+
+
+/************************************************************************
+ * Read the ignore file in a directory, if there is one. The rules use
+ * the same syntax as a .gitignore file, and are added on top of the
+ * parent rules. Returns the parent if there are no rules to add.
+ ***********************************************************************/
+
+IgnoreList* ignore_load(IgnoreList* parent, const char* dir)
+{
+	IgnoreList* list;
+	FILE* file;
+	char  buffer[8192];
+	int   len;
+
+	strcpy(buffer, dir);
+	len = strlen(buffer);
+	if (len > 0 && buffer[len - 1] != '/')
+		strcat(buffer, "/");
+	strcat(buffer, IGNORE_FILE);
+
+	file = fopen(buffer, "r");
+	if (file == NULL)
+		return parent;
+
+	list = ALLOCT(IgnoreList);
+	list->dir = (char*)malloc(strlen(dir) + 1);
+	strcpy(list->dir, dir);
+	list->rules  = NULL;
+	list->count  = 0;
+	list->parent = parent;
+
+	while (fgets(buffer, 8192, file) != NULL)
+		addRule(list, buffer);
+	fclose(file);
+
+	if (list->count == 0)
+	{
+		ignore_free(list);
+		return parent;
+	}
+
+	return list;
+}
+
+
+/************************************************************************
+ * Test a path against a set of rules. The path is in the same form as
+ * the directories the rules were loaded from. As with git, the last
+ * rule that matches decides, and rules in a subdirectory come after
+ * those of the directories above it.
+ ***********************************************************************/
+
+int ignore_test(IgnoreList* list, const char* path, int isdir)
+{
+	return (list != NULL) ? testList(list, path, isdir) : 0;
+}
+
+
+void ignore_free(IgnoreList* list)
+{
+	int i;
+	for (i = 0; i < list->count; ++i)
+		free(list->rules[i].pattern);
+	free(list->rules);
+	free(list->dir);
+	free(list);
+}
+
+
+static void addRule(IgnoreList* list, const char* line)
+{
+	IgnoreRule* rule;
+	char pattern[8192];
+	int  negate, anchored, dirOnly, len;
+
+	strcpy(pattern, line);
+	len = strlen(pattern);
+	while (len > 0 && (pattern[len - 1] == '\n' || pattern[len - 1] == '\r' || pattern[len - 1] == ' ' || pattern[len - 1] == '\t'))
+		pattern[--len] = '\0';
+
+	if (len == 0 || pattern[0] == '#')
+		return;
+
+	line = pattern;
+	negate = 0;
+	if (line[0] == '!')
+	{
+		negate = 1;
+		line++;
+	}
+	else if (line[0] == '\\')
+	{
+		/* Escapes a leading "#" or "!" */
+		line++;
+	}
+
+	dirOnly = 0;
+	len = strlen(line);
+	if (len > 0 && line[len - 1] == '/')
+	{
+		dirOnly = 1;
+		pattern[(line - pattern) + len - 1] = '\0';
+	}
+
+	/* A slash anywhere but the end ties the rule to this directory;
+	 * otherwise it matches the name at any depth */
+	anchored = (strchr(line, '/') != NULL);
+	if (line[0] == '/')
+		line++;
+
+	if (strlen(line) == 0)
+		return;
+
+	list->rules = (IgnoreRule*)realloc(list->rules, sizeof(IgnoreRule) * (list->count + 1));
+	rule = &list->rules[list->count++];
+	rule->pattern = (char*)malloc(strlen(line) + 1);
+	strcpy(rule->pattern, line);
+	rule->negate   = negate;
+	rule->anchored = anchored;
+	rule->dirOnly  = dirOnly;
+}
+
+
+static int testList(IgnoreList* list, const char* path, int isdir)
+{
+	const char* rel;
+	const char* name;
+	int result, len, i;
+
+	result = (list->parent != NULL) ? testList(list->parent, path, isdir) : 0;
+
+	/* Make the path relative to the directory holding the rules */
+	rel = path;
+	len = strlen(list->dir);
+	if (len > 0)
+	{
+		if (strncmp(path, list->dir, len) != 0)
+			return result;
+		if (list->dir[len - 1] == '/')
+			rel = path + len;
+		else if (path[len] == '/')
+			rel = path + len + 1;
+		else
+			return result;
+	}
+
+	name = strrchr(rel, '/');
+	name = (name != NULL) ? name + 1 : rel;
+
+	for (i = 0; i < list->count; ++i)
+	{
+		IgnoreRule* rule = &list->rules[i];
+		if (rule->dirOnly && !isdir)
+			continue;
+		if (match_path(rule->pattern, rule->anchored ? rel : name))
+			result = !rule->negate;
+	}
+
+	return result;
+}
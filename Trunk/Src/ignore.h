@@ -0,0 +1,39 @@
+/**********************************************************************
+ * Premake - ignore.h
+ * Ignore rules that prune file searches.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#define IGNORE_FILE  ".premakeignore"
+
+typedef struct tagIgnoreRule
+{
+	char* pattern;
+	int   negate;
+	int   anchored;
+	int   dirOnly;
+} IgnoreRule;
+
+typedef struct tagIgnoreList
+{
+	char*       dir;
+	IgnoreRule* rules;
+	int         count;
+	struct tagIgnoreList* parent;
+} IgnoreList;
+
+IgnoreList* ignore_defaults();
+IgnoreList* ignore_load(IgnoreList* parent, const char* dir);
+int         ignore_test(IgnoreList* list, const char* path, int isdir);
+void        ignore_free(IgnoreList* list);
@@ -16,15 +16,43 @@
  **********************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <sys/stat.h>
 #include "io.h"
 #include "path.h"
 #include "platform.h"
+#include "util.h"
 
-static char buffer[8192];
-static FILE* file;
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define vsnprintf  _vsnprintf
+#endif
+
+static THREAD_LOCAL char buffer[8192];
+
+/* Output is collected here and only written out by io_closefile() if it
+ * differs from what is already on disk, so unchanged files keep their
+ * timestamps. Most files fit in the fixed block; bigger ones move to the
+ * heap until they are closed. Changed files are written next to the old
+ * one under a temporary name and then moved over it, so an interrupted
+ * run never leaves a file half written */
+static THREAD_LOCAL char  my_block[32768];
+static THREAD_LOCAL char* my_text;
+static THREAD_LOCAL int   my_length;
+static THREAD_LOCAL int   my_size;
+static THREAD_LOCAL char  my_path[8192];
+
+/* Told about each file that is opened for writing */
+static void (*my_listener)(const char* path) = NULL;
+
+static int  my_verbose = 0;
+
+static void appendText(const char* text, int len);
+static int  formatText(const char* format, va_list args);
+static void growText(int needed);
+static int  isUnchanged();
+static int  writeText();
 
 
 int io_chdir(const char* path)
@@ -34,8 +62,22 @@ int io_chdir(const char* path)
 
 int io_closefile()
 {
-	fclose(file);
-	return 1;
+	int result = 1;
+
+	if (isUnchanged())
+	{
+		if (my_verbose)
+			printf("Unchanged %s\n", my_path);
+	}
+	else
+	{
+		result = writeText();
+	}
+
+	if (my_text != my_block)
+		free(my_text);
+	my_text = NULL;
+	return result;
 }
 
 
@@ -84,6 +126,12 @@ int io_mask_close(MaskHandle data)
 }
 
 
+const char* io_mask_getentry(MaskHandle data)
+{
+	return platform_mask_getentry(data);
+}
+
+
 const char* io_mask_getname(MaskHandle data)
 {
 	return platform_mask_getname(data);
@@ -96,6 +144,12 @@ int io_mask_getnext(MaskHandle data)
 }
 
 
+int io_mask_isdir(MaskHandle data)
+{
+	return platform_mask_isdir(data);
+}
+
+
 int io_mask_isfile(MaskHandle data)
 {
 	return platform_mask_isfile(data);
@@ -108,30 +162,34 @@ MaskHandle io_mask_open(const char* mask)
 }
 
 
+MaskHandle io_mask_opensub(MaskHandle parent, const char* dir, const char* mask)
+{
+	return platform_mask_opensub(parent, dir, mask);
+}
+
+
 int io_mkdir(const char* path)
 {
-	/* Remember the current directory */
-	char cwd[8192];
-	platform_getcwd(cwd, 8192);
+	char* ptr;
 
-	/* Split the path and check each part in turn */
+	/* Create each leading part of the path in turn. This doesn't change
+	 * directory, so packages can be written from more than one thread */
 	strcpy(buffer, path);
-	path = buffer;
+	ptr = buffer;
 
-	while (path != NULL)
+	while (ptr != NULL)
 	{
-		char* ptr = strchr(path, '/');
+		ptr = strchr(ptr, '/');
 		if (ptr != NULL)
 			*ptr = '\0';
 
-		platform_mkdir(path);
-		platform_chdir(path);
+		if (strlen(buffer) > 0)
+			platform_mkdir(buffer);
 
-		path = (ptr != NULL) ? ptr + 1 : NULL;
+		if (ptr != NULL)
+			*(ptr++) = '/';
 	}
 
-	/* Restore the original working directory */
-	platform_chdir(cwd);
 	return 1;
 }
 
@@ -141,26 +199,47 @@ int io_openfile(const char* path)
 	/* Make sure that all parts of the path exist */
 	io_mkdir(path_getdir(path));
 
-	/* Now I can open the file */
-	file = fopen(path, "w");
-	if (file == NULL)
-	{
-		printf("** Unable to open file '%s' for writing\n", path);
-		return 0;
-	}
-	else
-	{
-		return 1;
-	}
+	/* Nothing touches the disk until the file is closed */
+	strcpy(my_path, path);
+	my_text   = my_block;
+	my_size   = sizeof(my_block);
+	my_length = 0;
+
+	if (my_listener != NULL)
+		my_listener(path);
+	return 1;
 }
 
 
 void io_print(const char* format, ...)
 {
 	va_list args;
+	int start = my_length;
+	int done, len;
+
+	/* Nearly everything written is plain text and strings */
 	va_start(args, format);
-	vfprintf(file, format, args);
+	done = formatText(format, args);
 	va_end(args);
+	if (done)
+		return;
+
+	/* Otherwise start over with the full formatter. If it doesn't fit,
+	 * make room and format it again. Older Windows runtimes don't say
+	 * how much room is needed, so just double it */
+	my_length = start;
+	for (;;)
+	{
+		va_start(args, format);
+		len = vsnprintf(my_text + my_length, my_size - my_length, format, args);
+		va_end(args);
+
+		if (len >= 0 && len < my_size - my_length)
+			break;
+		growText(len >= 0 ? len : my_size);
+	}
+
+	my_length += len;
 }
 
 
@@ -181,4 +260,161 @@ int io_rmdir(const char* path, const char* dir)
 }
 
 
+void io_setlistener(void (*listener)(const char* path))
+{
+	my_listener = listener;
+}
+
+
+void io_setverbose(int enabled)
+{
+	my_verbose = enabled;
+}
+
+
+/************************************************************************
+ * Append text to the output, and the fast path for io_print(), which
+ * handles the %s, %d, and %% conversions that the generators use. Returns
+ * zero on anything else, leaving it to vsnprintf()
+ ***********************************************************************/
+
+static void appendText(const char* text, int len)
+{
+	if (len >= my_size - my_length)
+		growText(len);
+	memcpy(my_text + my_length, text, len);
+	my_length += len;
+}
+
+static int formatText(const char* format, va_list args)
+{
+	const char* ptr = format;
+	const char* str;
+	char number[32];
+
+	for (;;)
+	{
+		const char* end = strchr(ptr, '%');
+		if (end == NULL)
+		{
+			appendText(ptr, strlen(ptr));
+			return 1;
+		}
+		appendText(ptr, end - ptr);
+
+		switch (end[1])
+		{
+		case 's':
+			str = va_arg(args, const char*);
+			if (str == NULL)
+				str = "(null)";
+			appendText(str, strlen(str));
+			break;
+		case 'd':
+			sprintf(number, "%d", va_arg(args, int));
+			appendText(number, strlen(number));
+			break;
+		case '%':
+			appendText("%", 1);
+			break;
+		default:
+			return 0;
+		}
+
+		ptr = end + 2;
+	}
+}
+
+
+/************************************************************************
+ * Make room for at least another `needed` characters, plus the
+ * terminator written by vsnprintf()
+ ***********************************************************************/
+
+static void growText(int needed)
+{
+	int size = my_size;
+	while (size - my_length <= needed)
+		size *= 2;
+
+	if (my_text == my_block)
+	{
+		my_text = (char*)malloc(size);
+		memcpy(my_text, my_block, my_length);
+	}
+	else
+	{
+		my_text = (char*)realloc(my_text, size);
+	}
+	my_size = size;
+}
+
+
+/************************************************************************
+ * Compare the collected output with the file already on disk. The file
+ * is read in text mode, as it was written
+ ***********************************************************************/
+
+static int isUnchanged()
+{
+	FILE* file;
+	int pos = 0;
+	int len;
+
+	file = fopen(my_path, "r");
+	if (file == NULL)
+		return 0;
+
+	while ((len = (int)fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		if (len > my_length - pos || memcmp(my_text + pos, buffer, len) != 0)
+			break;
+		pos += len;
+	}
+
+	len = (len == 0 && pos == my_length);
+	fclose(file);
+	return len;
+}
+
+
+/************************************************************************
+ * Write the output to a temporary file with a single unbuffered write,
+ * then move it over the old file
+ ***********************************************************************/
 
+static int writeText()
+{
+	char temp[8192];
+	FILE* file;
+	int result;
+
+	strcpy(temp, my_path);
+	strcat(temp, IO_TEMP_SUFFIX);
+
+	file = fopen(temp, "w");
+	if (file == NULL)
+	{
+		printf("** Unable to open file '%s' for writing\n", temp);
+		return 0;
+	}
+
+	/* The replacement takes the place of the old file, so it takes its
+	 * permissions too, instead of the defaults it was created with */
+	setvbuf(file, NULL, _IONBF, 0);
+	result = platform_copymode(my_path, file);
+	if (result)
+		result = ((int)fwrite(my_text, 1, my_length, file) == my_length);
+	if (fclose(file) != 0)
+		result = 0;
+
+	if (result && !platform_replacefile(temp, my_path))
+		result = 0;
+
+	if (!result)
+	{
+		printf("** Unable to write file '%s'\n", my_path);
+		platform_remove(temp);
+	}
+	return result;
+}
@@ -15,6 +15,9 @@
  * GNU General Public License in the file LICENSE.txt for details.
  **********************************************************************/
 
+/* Added to the name of a generated file while it is being written */
+#define IO_TEMP_SUFFIX  ".premake-tmp"
+
 struct PlatformMaskData;
 typedef struct PlatformMaskData* MaskHandle;
 
@@ -25,12 +28,17 @@ int         io_fileexists(const char* path);
 const char* io_findlib(const char* name);
 const char* io_getcwd();
 int         io_mask_close(MaskHandle data);
+const char* io_mask_getentry(MaskHandle data);
 const char* io_mask_getname(MaskHandle data);
 int         io_mask_getnext(MaskHandle data);
+int         io_mask_isdir(MaskHandle data);
 int         io_mask_isfile(MaskHandle data);
 MaskHandle  io_mask_open(const char* mask);
+MaskHandle  io_mask_opensub(MaskHandle parent, const char* dir, const char* mask);
 int         io_openfile(const char* path);
 void        io_print(const char* format, ...);
 int         io_remove(const char* path);
 int         io_rmdir(const char* path, const char* dir);
+void        io_setlistener(void (*listener)(const char* path));
+void        io_setverbose(int enabled);
 
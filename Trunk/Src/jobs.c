@@ -0,0 +1,113 @@
+/**********************************************************************
+ * Premake - jobs.c
+ * Runs independent pieces of generator work on a pool of threads.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "io.h"
+#include "jobs.h"
+#include "platform.h"
+
+static int         my_jobs = 1;
+static LockHandle  my_lock;
+static int       (*my_job)(int i);
+static int         my_count;
+static int         my_next;
+static int         my_failed;
+
+static void work(void* arg);
+
+
+/************************************************************************
+ * Set the number of threads used by jobs_run(), from --jobs
+ ***********************************************************************/
+
+void jobs_setcount(int count)
+{
+	my_jobs = (count > 0) ? count : 1;
+}
+
+
+/************************************************************************
+ * Call job(i) for each i from 0 to count - 1 and wait for all of them
+ * to finish. With a single job thread they run in order on the calling
+ * thread, and the first failure stops the rest. Otherwise the calling
+ * thread works alongside the pool, and once a job has failed no more
+ * are started. Returns 1 if every job succeeded.
+ ***********************************************************************/
+
+int jobs_run(int count, int (*job)(int i))
+{
+	ThreadHandle* threads;
+	int numThreads, i;
+
+	if (my_jobs <= 1 || count <= 1)
+	{
+		for (i = 0; i < count; ++i)
+		{
+			if (!job(i))
+				return 0;
+		}
+		return 1;
+	}
+
+	my_lock   = platform_lock_create();
+	my_job    = job;
+	my_count  = count;
+	my_next   = 0;
+	my_failed = 0;
+
+	numThreads = (my_jobs < count) ? my_jobs : count;
+	threads = (ThreadHandle*)malloc(sizeof(ThreadHandle) * numThreads);
+	for (i = 1; i < numThreads; ++i)
+		threads[i] = platform_thread_create(work, NULL);
+
+	work(NULL);
+
+	for (i = 1; i < numThreads; ++i)
+	{
+		if (threads[i] != NULL)
+			platform_thread_join(threads[i]);
+	}
+
+	free(threads);
+	platform_lock_destroy(my_lock);
+	return !my_failed;
+}
+
+
+static void work(void* arg)
+{
+	(void)arg;
+	for (;;)
+	{
+		int i;
+
+		platform_lock_acquire(my_lock);
+		i = (my_failed) ? my_count : my_next++;
+		platform_lock_release(my_lock);
+
+		if (i >= my_count)
+			return;
+
+		if (!my_job(i))
+		{
+			platform_lock_acquire(my_lock);
+			my_failed = 1;
+			platform_lock_release(my_lock);
+		}
+	}
+}
@@ -0,0 +1,1142 @@
+/**********************************************************************
+ * Premake - match.c
+ * File pattern matching for matchfiles() and matchrecursive().
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "premake.h"
+#include "os.h"
+#include "platform.h"
+#include "dircache.h"
+#include "gitindex.h"
+#include "hash.h"
+#include "ignore.h"
+#include "match.h"
+#include "pattern.h"
+
+#define ISEND(c)   ((c) == '/' || (c) == '\0')
+
+/* Limit on directory handles held open by queued directories; past
+ * this, queued directories are reopened by path instead */
+#define MAX_OPEN_DIRS   64
+
+typedef struct tagMatchRoot
+{
+	char*         base;
+	char*         abspath;
+	const char**  patterns;
+	int           count;
+} MatchRoot;
+
+typedef struct tagMatchDir
+{
+	MaskHandle    handle;
+	MatchRoot*    root;
+	char*         rel;
+	const char**  patterns;
+	int           count;
+	IgnoreList*   ignores;
+	struct tagMatchDir* next;
+} MatchDir;
+
+typedef struct tagMatchVisit
+{
+	char*         path;
+	const char**  patterns;
+	int           count;
+} MatchVisit;
+
+typedef struct tagIndexDir
+{
+	IgnoreList*   ignores;
+	int           ignored;
+} IndexDir;
+
+typedef struct tagMatchWorker
+{
+	char**        files;
+	int           numFiles;
+	int           maxFiles;
+	MatchVisit*   visits;
+	int           numVisits;
+	int           maxVisits;
+	int           numSkipped;
+	ThreadHandle  thread;
+} MatchWorker;
+
+static int        my_threads = 1;
+static int        my_gitindex = 0;
+static int        my_untracked = 0;
+static void     (*my_listener)(const char*, const char**, int) = NULL;
+static LockHandle my_lock;
+static MatchDir*  my_queue;
+static int        my_pending;
+static int        my_openDirs;
+static IgnoreList** my_ignores;
+static int        my_numIgnores;
+static int        my_skipped = 0;
+static PatternSet* my_patterns;
+
+/* In place of the directories, a search of the index watches the file */
+static const char* INDEX_PATTERNS[] = { "index" };
+
+static void addFile(MatchWorker* worker, char* path);
+static void addVisit(MatchWorker* worker, const char* path, const char** patterns, int count);
+static int  compareFiles(const void* a, const void* b);
+static int  isDoubleStar(const char* pattern);
+static int  isLiteral(const char* str, int len);
+static int  isNestedPath(const char* str, int len);
+static void joinPath(char* buffer, const char* base, const char* rel);
+static IgnoreList* loadIgnores(IgnoreList* parent, const char* dir);
+static int  scanIndex(MatchWorker* worker, MatchRoot* root, IgnoreList* ignores);
+static IndexDir* getIndexDir(Hash* dirs, MatchWorker* worker, GitIndex* index, const char* prefix, MatchRoot* root, IgnoreList* ignores, const char* dir);
+static int  matchPrefix(const char* pattern, const char* dir);
+static int  matchSegment(const char* pattern, const char* str);
+static const char* nextSegment(const char* str);
+static int  nextEntry(MaskHandle handle, DirListing* listing, int* index, const char** name, int* type);
+static void visit(MatchWorker* worker, MatchDir* dir);
+static void work(void* arg);
+
+
+/************************************************************************
+ * Test a path against a pattern. Single stars and question marks
+ * stay within one path segment, while a "**" segment matches any
+ * number of directories, including none at all.
+ ***********************************************************************/
+
+int match_path(const char* pattern, const char* path)
+{
+	while (1)
+	{
+		if (isDoubleStar(pattern))
+		{
+			pattern = nextSegment(pattern);
+			if (pattern == NULL)
+				return 1;
+
+			while (path != NULL)
+			{
+				if (match_path(pattern, path))
+					return 1;
+				path = nextSegment(path);
+			}
+			return 0;
+		}
+
+		if (!matchSegment(pattern, path))
+			return 0;
+
+		pattern = nextSegment(pattern);
+		path = nextSegment(path);
+		if (pattern == NULL || path == NULL)
+			return (pattern == NULL && path == NULL);
+	}
+}
+
+
+/************************************************************************
+ * Scan the file system for files matching any of a list of patterns.
+ * Patterns are grouped by the literal directory at their front, and
+ * each group is matched in a single pass over its directory tree, so
+ * adding more patterns does not add more directory reads. Patterns
+ * starting with "!" exclude the files they match. Directories and
+ * files excluded by ignore rules are left out of the walk. When
+ * enabled, roots inside a Git work tree are answered from its index
+ * instead. The matches are passed to the callback in sorted order.
+ ***********************************************************************/
+
+int match_scan(const char** patterns, int count, void (*cb)(const char*))
+{
+	MatchRoot*   roots;
+	MatchWorker* workers;
+	char** files;
+	char   rel[8192];
+	int    numRoots, numFiles, i, j, len;
+
+	/* Every file found is tested against all of the patterns at once */
+	my_patterns = pattern_compile(patterns, count);
+
+	/* Split each pattern into a base directory and a relative part. The
+	 * roots are kept shortest-first so that nested bases can be folded
+	 * into the walk of an enclosing one. Excludes never need a walk. */
+	roots = (MatchRoot*)malloc(sizeof(MatchRoot) * count);
+	numRoots = 0;
+	for (i = 0; i < count; ++i)
+	{
+		const char* pattern = patterns[i];
+		const char* ptr;
+		char* base;
+
+		if (pattern[0] == '!')
+			continue;
+
+		len = 0;
+		for (ptr = pattern; nextSegment(ptr) != NULL; ptr = nextSegment(ptr))
+		{
+			const char* end = strchr(ptr, '/');
+			if (!isLiteral(ptr, end - ptr))
+				break;
+			len = end - pattern;
+		}
+
+		/* A pattern at the top of the file system keeps "/" as its base */
+		if (len == 0 && pattern[0] == '/')
+			len = 1;
+
+		base = (char*)malloc(len + 1);
+		strncpy(base, pattern, len);
+		base[len] = '\0';
+		ptr = pattern + len;
+		if (*ptr == '/' && len > 0 && base[len - 1] != '/')
+			ptr++;
+
+		/* Is this base the same as, or nested within, a known root? */
+		for (j = 0; j < numRoots; ++j)
+		{
+			int rootlen = strlen(roots[j].base);
+			if (matches(roots[j].base, base))
+				break;
+			if (rootlen == 0 && base[0] != '/' && strchr(base, ':') == NULL && isNestedPath(base, len))
+				break;
+			if (rootlen > 0 && strncmp(roots[j].base, base, rootlen) == 0 && base[rootlen] == '/' && isNestedPath(base + rootlen + 1, len - rootlen - 1))
+				break;
+		}
+
+		if (j == numRoots)
+		{
+			int k;
+
+			/* Insert a new root, keeping the list ordered by length */
+			for (k = numRoots; k > 0 && (int)strlen(roots[k - 1].base) > len; --k)
+				roots[k] = roots[k - 1];
+			roots[k].base = base;
+			roots[k].patterns = (const char**)malloc(sizeof(char*) * count);
+			roots[k].count = 0;
+			numRoots++;
+			j = k;
+			base = NULL;
+		}
+
+		/* Store the pattern relative to the root it was assigned to */
+		if (base == NULL || matches(roots[j].base, base))
+		{
+			strcpy(rel, ptr);
+		}
+		else
+		{
+			len = strlen(roots[j].base);
+			strcpy(rel, pattern + len + (len > 0 ? 1 : 0));
+		}
+
+		roots[j].patterns[roots[j].count] = (char*)malloc(strlen(rel) + 1);
+		strcpy((char*)roots[j].patterns[roots[j].count], rel);
+		roots[j].count++;
+
+		if (base != NULL)
+			free(base);
+	}
+
+	/* The calling thread works alongside any helper threads, which are
+	 * started once the roots have been queued */
+	workers = (MatchWorker*)malloc(sizeof(MatchWorker) * my_threads);
+	for (i = 0; i < my_threads; ++i)
+	{
+		workers[i].numFiles = 0;
+		workers[i].maxFiles = 64;
+		workers[i].files    = (char**)malloc(sizeof(char*) * workers[i].maxFiles);
+		workers[i].numVisits = 0;
+		workers[i].maxVisits = 0;
+		workers[i].visits    = NULL;
+		workers[i].numSkipped = 0;
+		workers[i].thread   = NULL;
+	}
+
+	/* Queue up the root directories, then walk the trees */
+	my_lock     = platform_lock_create();
+	my_queue    = NULL;
+	my_pending  = 0;
+	my_openDirs = 0;
+	my_ignores  = NULL;
+	my_numIgnores = 0;
+	for (i = numRoots - 1; i >= 0; --i)
+	{
+		MatchDir* dir;
+		IgnoreList* ignores = ignore_defaults();
+
+		/* A root below the project directory picks up the ignore files of
+		 * the directories above it; its own is found by the walk */
+		len = strlen(roots[i].base);
+		if (len > 0 && isNestedPath(roots[i].base, len))
+		{
+			ignores = loadIgnores(ignores, "");
+			for (j = 0; j < len; ++j)
+			{
+				if (roots[i].base[j] == '/')
+				{
+					strncpy(rel, roots[i].base, j);
+					rel[j] = '\0';
+					ignores = loadIgnores(ignores, rel);
+				}
+			}
+		}
+
+		/* Tracked files can be read from the Git index, leaving only the
+		 * untracked ones to be found by walking the tree, if wanted */
+		roots[i].abspath = NULL;
+		if (my_gitindex && scanIndex(&workers[0], &roots[i], ignores) && !my_untracked)
+			continue;
+
+		/* The cache is keyed by absolute path */
+		if (dircache_isopen())
+		{
+			const char* abspath = path_absolute(roots[i].base);
+			roots[i].abspath = (char*)malloc(strlen(abspath) + 1);
+			strcpy(roots[i].abspath, abspath);
+			len = strlen(roots[i].abspath);
+			if (len > 1 && roots[i].abspath[len - 1] == '/')
+				roots[i].abspath[len - 1] = '\0';
+		}
+
+		/* With a cache, a directory isn't opened until it is known to
+		 * have changed */
+		dir = ALLOCT(MatchDir);
+		dir->handle = NULL;
+		if (!dircache_isopen())
+		{
+			strcpy(rel, roots[i].base);
+			if (strlen(rel) > 0 && rel[strlen(rel) - 1] != '/')
+				strcat(rel, "/");
+			strcat(rel, "*");
+			dir->handle = io_mask_open(rel);
+			my_openDirs++;
+		}
+		dir->root     = &roots[i];
+		dir->rel      = (char*)malloc(1);
+		dir->rel[0]   = '\0';
+		dir->patterns = (const char**)malloc(sizeof(char*) * roots[i].count);
+		memcpy((void*)dir->patterns, roots[i].patterns, sizeof(char*) * roots[i].count);
+		dir->count    = roots[i].count;
+		dir->ignores  = ignores;
+		dir->next     = my_queue;
+		my_queue = dir;
+		my_pending++;
+	}
+
+	for (i = 1; i < my_threads; ++i)
+		workers[i].thread = platform_thread_create(work, &workers[i]);
+
+	work(&workers[0]);
+
+	numFiles = 0;
+	for (i = 0; i < my_threads; ++i)
+	{
+		if (workers[i].thread != NULL)
+			platform_thread_join(workers[i].thread);
+		numFiles += workers[i].numFiles;
+		my_skipped += workers[i].numSkipped;
+	}
+
+	platform_lock_destroy(my_lock);
+	for (i = 0; i < my_numIgnores; ++i)
+		ignore_free(my_ignores[i]);
+	free(my_ignores);
+	if (dircache_isopen())
+		dircache_commit();
+
+	/* Merge the results, and sort them so the order does not depend on
+	 * the file system or on the way the work was divided up */
+	files = (char**)malloc(sizeof(char*) * (numFiles + 1));
+	numFiles = 0;
+	for (i = 0; i < my_threads; ++i)
+	{
+		memcpy(files + numFiles, workers[i].files, sizeof(char*) * workers[i].numFiles);
+		numFiles += workers[i].numFiles;
+		free(workers[i].files);
+	}
+
+	qsort(files, numFiles, sizeof(char*), compareFiles);
+	for (i = 0; i < numFiles; ++i)
+	{
+		/* Overlapping roots can find the same file more than once */
+		if (i == 0 || strcmp(files[i], files[i - 1]) != 0)
+			cb(files[i]);
+		if (i > 0)
+			free(files[i - 1]);
+	}
+	if (numFiles > 0)
+		free(files[numFiles - 1]);
+	free(files);
+
+	/* Let the listener know which directories were searched, and for what */
+	for (i = 0; i < my_threads; ++i)
+	{
+		for (j = 0; j < workers[i].numVisits; ++j)
+		{
+			MatchVisit* visit = &workers[i].visits[j];
+			my_listener(visit->path, visit->patterns, visit->count);
+			free(visit->path);
+			free((void*)visit->patterns);
+		}
+		free(workers[i].visits);
+	}
+	free(workers);
+
+	for (i = 0; i < numRoots; ++i)
+	{
+		for (j = 0; j < roots[i].count; ++j)
+			free((void*)roots[i].patterns[j]);
+		free((void*)roots[i].patterns);
+		free(roots[i].base);
+		free(roots[i].abspath);
+	}
+
+	free(roots);
+	pattern_free(my_patterns);
+	return 1;
+}
+
+
+/************************************************************************
+ * Return the number of directories that ignore rules have kept out of
+ * searches so far
+ ***********************************************************************/
+
+int match_getskipped()
+{
+	return my_skipped;
+}
+
+
+/************************************************************************
+ * Answer searches inside of a Git work tree from the list of tracked
+ * files in its index. Untracked files are only found if asked for,
+ * by walking the tree as well.
+ ***********************************************************************/
+
+void match_setgitindex(int enabled)
+{
+	my_gitindex = enabled;
+}
+
+void match_setuntracked(int enabled)
+{
+	my_untracked = enabled;
+}
+
+
+/************************************************************************
+ * Set a function to be told about each directory that gets searched,
+ * along with the patterns that were tested against its contents
+ ***********************************************************************/
+
+void match_setlistener(void (*listener)(const char* dir, const char** patterns, int count))
+{
+	my_listener = listener;
+}
+
+
+/************************************************************************
+ * Set the number of threads used to walk directory trees
+ ***********************************************************************/
+
+void match_setthreads(int threads)
+{
+	my_threads = (threads > 0) ? threads : 1;
+}
+
+
+/************************************************************************
+ * Worker thread loop: take a directory off of the queue and visit it,
+ * until the queue is empty and no other worker can add anything more
+ ***********************************************************************/
+
+static void work(void* arg)
+{
+	MatchWorker* worker = (MatchWorker*)arg;
+	MatchDir* dir;
+
+	platform_lock_acquire(my_lock);
+	while (1)
+	{
+		while (my_queue == NULL && my_pending > 0)
+			platform_lock_wait(my_lock);
+
+		if (my_queue == NULL)
+			break;
+
+		dir = my_queue;
+		my_queue = dir->next;
+		platform_lock_release(my_lock);
+
+		visit(worker, dir);
+
+		platform_lock_acquire(my_lock);
+		my_pending--;
+		if (my_pending == 0)
+			platform_lock_notify(my_lock);
+	}
+	platform_lock_release(my_lock);
+}
+
+
+/************************************************************************
+ * Visit one directory, collecting matching files and queuing up the
+ * subdirectories that some pattern could still match below. While
+ * handles are available, the subdirectories are opened relative to
+ * this one.
+ ***********************************************************************/
+
+static void visit(MatchWorker* worker, MatchDir* dir)
+{
+	MaskHandle  handle;
+	DirListing* listing;
+	DirListing* fresh;
+	MatchDir*   children;
+	MatchDir*   child;
+	IgnoreList* ignores;
+	const char* name;
+	char   rel[8192];
+	char   full[8192];
+	char   stamp[256];
+	char** subdirs;
+	long   changed;
+	int    numSubdirs, maxSubdirs, numChildren, numOpen, rellen;
+	int    firstFile, hasIgnoreFile, cursor, i, j, type;
+	int*   active;
+	int    numActive;
+
+	const char* base = dir->root->base;
+
+	/* If the directory is unchanged since it was cached, the saved
+	 * listing can be used instead of reading the directory again */
+	handle  = dir->handle;
+	listing = NULL;
+	fresh   = NULL;
+	if (dircache_isopen())
+	{
+		strcpy(rel, dir->root->abspath);
+		if (strlen(dir->rel) > 0)
+		{
+			if (rel[strlen(rel) - 1] != '/')
+				strcat(rel, "/");
+			strcat(rel, dir->rel);
+		}
+
+		if (platform_dirstamp(rel, stamp, &changed))
+		{
+			listing = dircache_find(rel, stamp);
+			if (listing == NULL)
+				fresh = dircache_new(rel, stamp);
+		}
+
+		if (listing != NULL && handle != NULL)
+		{
+			io_mask_close(handle);
+			handle = NULL;
+		}
+	}
+
+	if (handle == NULL && listing == NULL)
+	{
+		strcpy(rel, base);
+		if (strlen(rel) > 0 && strlen(dir->rel) > 0 && rel[strlen(rel) - 1] != '/')
+			strcat(rel, "/");
+		strcat(rel, dir->rel);
+		if (strlen(rel) > 0 && rel[strlen(rel) - 1] != '/')
+			strcat(rel, "/");
+		strcat(rel, "*");
+		handle = io_mask_open(rel);
+	}
+
+	numSubdirs = 0;
+	maxSubdirs = 16;
+	subdirs = (char**)malloc(sizeof(char*) * maxSubdirs);
+
+	/* Patterns are matched against the full path, so only the groups for
+	 * this directory need to be looked at for each file */
+	joinPath(full, base, dir->rel);
+	active = (int*)malloc(sizeof(int) * (my_patterns->numGroups + 1));
+	numActive = pattern_select(my_patterns, full, active);
+
+	if (my_listener != NULL)
+		addVisit(worker, (strlen(full) > 0) ? full : ".", dir->patterns, dir->count);
+
+	strcpy(rel, dir->rel);
+	rellen = strlen(rel);
+	firstFile = worker->numFiles;
+	hasIgnoreFile = 0;
+	cursor = 0;
+	while (nextEntry(handle, listing, &cursor, &name, &type))
+	{
+		if (matches(name, ".") || matches(name, ".."))
+			continue;
+
+		if (type == DC_FILE && matches(name, IGNORE_FILE))
+			hasIgnoreFile = 1;
+
+		if (fresh != NULL && type != 0)
+			dircache_add(fresh, name, type);
+
+		if (rellen > 0)
+			strcat(rel, "/");
+		strcat(rel, name);
+
+		if (type == DC_FILE)
+		{
+			if (pattern_test(my_patterns, active, numActive, full, name) == PATTERN_INCLUDE)
+			{
+				/* Keep the file with the base path put back on */
+				char* path = (char*)malloc(strlen(base) + strlen(rel) + 2);
+				strcpy(path, base);
+				if (strlen(path) > 0 && path[strlen(path) - 1] != '/')
+					strcat(path, "/");
+				strcat(path, rel);
+				addFile(worker, path);
+			}
+		}
+		else if (type == DC_DIR)
+		{
+			if (numSubdirs == maxSubdirs)
+			{
+				maxSubdirs *= 2;
+				subdirs = (char**)realloc(subdirs, sizeof(char*) * maxSubdirs);
+			}
+			subdirs[numSubdirs] = (char*)malloc(strlen(name) + 1);
+			strcpy(subdirs[numSubdirs], name);
+			numSubdirs++;
+		}
+
+		rel[rellen] = '\0';
+	}
+
+	/* The directory's own ignore file applies to everything in it, and
+	 * may have been listed after some of the files it excludes */
+	ignores = dir->ignores;
+	if (hasIgnoreFile)
+	{
+		joinPath(full, base, dir->rel);
+		ignores = loadIgnores(ignores, full);
+	}
+
+	j = firstFile;
+	for (i = firstFile; i < worker->numFiles; ++i)
+	{
+		if (ignore_test(ignores, worker->files[i], 0))
+			free(worker->files[i]);
+		else
+			worker->files[j++] = worker->files[i];
+	}
+	worker->numFiles = j;
+
+	/* Descend only where a pattern might match something further down */
+	children = NULL;
+	numChildren = 0;
+	for (i = numSubdirs - 1; i >= 0; --i)
+	{
+		if (rellen > 0)
+			strcat(rel, "/");
+		strcat(rel, subdirs[i]);
+
+		child = ALLOCT(MatchDir);
+		child->handle   = NULL;
+		child->root     = dir->root;
+		child->patterns = (const char**)malloc(sizeof(char*) * dir->count);
+		child->count    = 0;
+		for (j = 0; j < dir->count; ++j)
+		{
+			if (matchPrefix(dir->patterns[j], rel))
+				child->patterns[child->count++] = dir->patterns[j];
+		}
+
+		if (child->count > 0)
+		{
+			joinPath(full, base, rel);
+			if (ignore_test(ignores, full, 1))
+			{
+				worker->numSkipped++;
+				child->count = 0;
+			}
+		}
+
+		if (child->count > 0)
+		{
+			child->rel = (char*)malloc(strlen(rel) + 1);
+			strcpy(child->rel, rel);
+			child->ignores = ignores;
+			child->next = children;
+			children = child;
+			numChildren++;
+		}
+		else
+		{
+			free((void*)child->patterns);
+			free(child);
+		}
+
+		rel[rellen] = '\0';
+	}
+
+	/* Reserve as many handles as are free, and open that many children.
+	 * A directory served from the cache has no handle to open them from,
+	 * and they are likely to be served from the cache as well. */
+	if (handle != NULL)
+	{
+		platform_lock_acquire(my_lock);
+		numOpen = MAX_OPEN_DIRS - my_openDirs;
+		if (numOpen > numChildren)
+			numOpen = numChildren;
+		if (numOpen < 0)
+			numOpen = 0;
+		my_openDirs += numOpen;
+		platform_lock_release(my_lock);
+
+		for (child = children; child != NULL && numOpen > 0; child = child->next, --numOpen)
+			child->handle = io_mask_opensub(handle, child->rel + (rellen > 0 ? rellen + 1 : 0), "*");
+
+		io_mask_close(handle);
+	}
+
+	for (i = 0; i < numSubdirs; ++i)
+		free(subdirs[i]);
+	free(subdirs);
+	free(active);
+
+	/* Hand the children over to the queue, to be picked up by any worker */
+	platform_lock_acquire(my_lock);
+	if (dir->handle != NULL)
+		my_openDirs--;
+	if (fresh != NULL)
+		dircache_store(fresh, changed);
+	if (children != NULL)
+	{
+		child = children;
+		while (child->next != NULL)
+			child = child->next;
+		child->next = my_queue;
+		my_queue = children;
+		my_pending += numChildren;
+		platform_lock_notify(my_lock);
+	}
+	platform_lock_release(my_lock);
+
+	free((void*)dir->patterns);
+	free(dir->rel);
+	free(dir);
+}
+
+
+/************************************************************************
+ * Find the files under a root from the index of the Git work tree that
+ * contains it. Ignore rules are applied the same way as for a walk,
+ * using the ignore files that are tracked. Returns zero if the root is
+ * not in a work tree with a readable index.
+ ***********************************************************************/
+
+static int scanIndex(MatchWorker* worker, MatchRoot* root, IgnoreList* ignores)
+{
+	GitIndex* index;
+	IndexDir* state;
+	Hash* dirs;
+	char  abspath[8192];
+	char  prefix[8192];
+	char  dir[8192];
+	char  last[8192];
+	char  dirpath[8192];
+	char  full[8192];
+	char* sep;
+	int*  active;
+	int   numActive, first, prefixLen, len, i;
+
+	strcpy(abspath, path_absolute(root->base));
+	len = strlen(abspath);
+	if (len > 1 && abspath[len - 1] == '/')
+		abspath[len - 1] = '\0';
+
+	index = gitindex_find(abspath);
+	if (index == NULL)
+		return 0;
+
+	/* Tracked paths are relative to the top of the work tree */
+	len = strlen(index->worktree);
+	if (matches(abspath, index->worktree))
+		strcpy(prefix, "");
+	else if (index->worktree[len - 1] == '/')
+		sprintf(prefix, "%s/", abspath + len);
+	else
+		sprintf(prefix, "%s/", abspath + len + 1);
+	prefixLen = strlen(prefix);
+
+	/* Paths in the same directory are mostly next to each other, so the
+	 * pattern groups are only selected again when the directory changes */
+	dirs = hash_create();
+	active = (int*)malloc(sizeof(int) * (my_patterns->numGroups + 1));
+	numActive = 0;
+	/* No directory has this name, so the first path always selects */
+	strcpy(last, "\001");
+
+	first = gitindex_first(index, prefix);
+	for (i = first; i < index->count && strncmp(index->paths[i], prefix, prefixLen) == 0; ++i)
+	{
+		const char* rel = index->paths[i] + prefixLen;
+		const char* name;
+
+		strcpy(dir, rel);
+		sep = strrchr(dir, '/');
+		if (sep != NULL)
+			*sep = '\0';
+		else
+			dir[0] = '\0';
+		name = rel + strlen(dir) + (sep != NULL ? 1 : 0);
+
+		if (!matches(dir, last))
+		{
+			strcpy(last, dir);
+			joinPath(dirpath, root->base, dir);
+			numActive = pattern_select(my_patterns, dirpath, active);
+		}
+
+		if (pattern_test(my_patterns, active, numActive, dirpath, name) != PATTERN_INCLUDE)
+			continue;
+
+		state = getIndexDir(dirs, worker, index, prefix, root, ignores, dir);
+		if (state->ignored)
+			continue;
+
+		joinPath(full, root->base, rel);
+		if (ignore_test(state->ignores, full, 0))
+			continue;
+
+		sep = (char*)malloc(strlen(full) + 1);
+		strcpy(sep, full);
+		addFile(worker, sep);
+	}
+
+	for (i = 0; i < dirs->numBuckets; ++i)
+	{
+		HashEntry* entry;
+		for (entry = dirs->buckets[i]; entry != NULL; entry = entry->next)
+		{
+			free((void*)entry->key);
+			free(entry->value);
+		}
+	}
+	hash_destroy(dirs);
+	free(active);
+
+	/* Changes to the list of tracked files show up as a new index */
+	if (my_listener != NULL)
+		addVisit(worker, index->gitdir, INDEX_PATTERNS, 1);
+
+	return 1;
+}
+
+
+/************************************************************************
+ * Work out whether a directory in the index is ignored, and which rules
+ * apply to its contents, based on the directories above it
+ ***********************************************************************/
+
+static IndexDir* getIndexDir(Hash* dirs, MatchWorker* worker, GitIndex* index, const char* prefix, MatchRoot* root, IgnoreList* ignores, const char* dir)
+{
+	IndexDir* state;
+	IndexDir* parent;
+	char  path[8192];
+	char* key;
+	char* sep;
+
+	state = (IndexDir*)hash_find(dirs, dir);
+	if (state != NULL)
+		return state;
+
+	state = ALLOCT(IndexDir);
+	state->ignores = ignores;
+	state->ignored = 0;
+	if (strlen(dir) > 0)
+	{
+		strcpy(path, dir);
+		sep = strrchr(path, '/');
+		if (sep != NULL)
+			*sep = '\0';
+		else
+			path[0] = '\0';
+
+		parent = getIndexDir(dirs, worker, index, prefix, root, ignores, path);
+		state->ignores = parent->ignores;
+
+		joinPath(path, root->base, dir);
+		state->ignored = parent->ignored || ignore_test(parent->ignores, path, 1);
+		if (state->ignored && !parent->ignored)
+			worker->numSkipped++;
+	}
+
+	if (!state->ignored)
+	{
+		sprintf(path, "%s%s%s%s", prefix, dir, (strlen(dir) > 0) ? "/" : "", IGNORE_FILE);
+		if (gitindex_contains(index, path))
+		{
+			joinPath(path, root->base, dir);
+			state->ignores = loadIgnores(state->ignores, path);
+		}
+	}
+
+	key = (char*)malloc(strlen(dir) + 1);
+	strcpy(key, dir);
+	hash_insert(dirs, key, state);
+	return state;
+}
+
+
+/************************************************************************
+ * Step through the entries of a directory, either from an open handle
+ * or from a cached listing. The type is DC_FILE, DC_DIR, or zero for
+ * anything else.
+ ***********************************************************************/
+
+static int nextEntry(MaskHandle handle, DirListing* listing, int* index, const char** name, int* type)
+{
+	if (listing != NULL)
+	{
+		if (*index >= listing->count)
+			return 0;
+		*name = listing->names[*index];
+		*type = listing->types[*index];
+		(*index)++;
+		return 1;
+	}
+
+	if (!io_mask_getnext(handle))
+		return 0;
+
+	*name = io_mask_getentry(handle);
+	if (io_mask_isfile(handle))
+		*type = DC_FILE;
+	else if (io_mask_isdir(handle))
+		*type = DC_DIR;
+	else
+		*type = 0;
+	return 1;
+}
+
+
+/************************************************************************
+ * Pattern helpers
+ ***********************************************************************/
+
+static void addFile(MatchWorker* worker, char* path)
+{
+	if (worker->numFiles == worker->maxFiles)
+	{
+		worker->maxFiles *= 2;
+		worker->files = (char**)realloc(worker->files, sizeof(char*) * worker->maxFiles);
+	}
+	worker->files[worker->numFiles++] = path;
+}
+
+static void addVisit(MatchWorker* worker, const char* path, const char** patterns, int count)
+{
+	MatchVisit* visit;
+	if (worker->numVisits == worker->maxVisits)
+	{
+		worker->maxVisits = (worker->maxVisits > 0) ? worker->maxVisits * 2 : 16;
+		worker->visits = (MatchVisit*)realloc(worker->visits, sizeof(MatchVisit) * worker->maxVisits);
+	}
+
+	visit = &worker->visits[worker->numVisits++];
+	visit->path = (char*)malloc(strlen(path) + 1);
+	strcpy(visit->path, path);
+	visit->patterns = (const char**)malloc(sizeof(char*) * count);
+	memcpy((void*)visit->patterns, patterns, sizeof(char*) * count);
+	visit->count = count;
+}
+
+static int compareFiles(const void* a, const void* b)
+{
+	return strcmp(*(const char**)a, *(const char**)b);
+}
+
+static int charEquals(char c0, char c1)
+{
+#if defined(PLATFORM_WINDOWS)
+	return (tolower((unsigned char)c0) == tolower((unsigned char)c1));
+#else
+	return (c0 == c1);
+#endif
+}
+
+static int isDoubleStar(const char* pattern)
+{
+	return (pattern[0] == '*' && pattern[1] == '*' && ISEND(pattern[2]));
+}
+
+static int isLiteral(const char* str, int len)
+{
+	int i;
+	for (i = 0; i < len; ++i)
+	{
+		if (str[i] == '*' || str[i] == '?' || str[i] == '[')
+			return 0;
+	}
+	return 1;
+}
+
+static void joinPath(char* buffer, const char* base, const char* rel)
+{
+	strcpy(buffer, base);
+	if (strlen(buffer) > 0 && strlen(rel) > 0 && buffer[strlen(buffer) - 1] != '/')
+		strcat(buffer, "/");
+	strcat(buffer, rel);
+}
+
+static IgnoreList* loadIgnores(IgnoreList* parent, const char* dir)
+{
+	IgnoreList* list = ignore_load(parent, dir);
+
+	/* Keep track of the new rules, to be freed once the search is done */
+	if (list != parent)
+	{
+		platform_lock_acquire(my_lock);
+		my_ignores = (IgnoreList**)realloc(my_ignores, sizeof(IgnoreList*) * (my_numIgnores + 1));
+		my_ignores[my_numIgnores++] = list;
+		platform_lock_release(my_lock);
+	}
+
+	return list;
+}
+
+static int isNestedPath(const char* str, int len)
+{
+	int i, end;
+
+	/* Relative markers can't be folded into another root's walk */
+	for (i = 0; i < len; i = end + 1)
+	{
+		end = i;
+		while (end < len && str[end] != '/')
+			end++;
+		if (end == i || (end - i == 1 && str[i] == '.') || (end - i == 2 && str[i] == '.' && str[i + 1] == '.'))
+			return 0;
+	}
+
+	return isLiteral(str, len);
+}
+
+static int matchClass(const char** pattern, char c)
+{
+	const char* ptr = *pattern + 1;
+	int negate = 0;
+	int found  = 0;
+
+	if (*ptr == '!' || *ptr == '^')
+	{
+		negate = 1;
+		ptr++;
+	}
+
+	do
+	{
+		if (ISEND(*ptr))
+		{
+			/* Unterminated class; treat the bracket as a plain character */
+			*pattern = *pattern + 1;
+			return charEquals('[', c);
+		}
+
+		if (ptr[1] == '-' && ptr[2] != ']' && !ISEND(ptr[2]))
+		{
+			if (c >= ptr[0] && c <= ptr[2])
+				found = 1;
+			ptr += 3;
+		}
+		else
+		{
+			if (charEquals(*ptr, c))
+				found = 1;
+			ptr++;
+		}
+	} while (*ptr != ']');
+
+	*pattern = ptr + 1;
+	return (found != negate);
+}
+
+static int matchSegment(const char* pattern, const char* str)
+{
+	while (!ISEND(*pattern))
+	{
+		if (*pattern == '*')
+		{
+			while (*pattern == '*')
+				pattern++;
+			if (ISEND(*pattern))
+				return 1;
+
+			while (!ISEND(*str))
+			{
+				if (matchSegment(pattern, str))
+					return 1;
+				str++;
+			}
+			return 0;
+		}
+
+		if (ISEND(*str))
+			return 0;
+
+		if (*pattern == '[')
+		{
+			if (!matchClass(&pattern, *str))
+				return 0;
+		}
+		else
+		{
+			if (*pattern != '?' && !charEquals(*pattern, *str))
+				return 0;
+			pattern++;
+		}
+		str++;
+	}
+
+	return ISEND(*str);
+}
+
+static int matchPrefix(const char* pattern, const char* dir)
+{
+	while (dir != NULL)
+	{
+		if (isDoubleStar(pattern))
+			return 1;
+
+		/* The last segment of a pattern names files, never directories */
+		if (nextSegment(pattern) == NULL)
+			return 0;
+
+		if (!matchSegment(pattern, dir))
+			return 0;
+
+		pattern = nextSegment(pattern);
+		dir = nextSegment(dir);
+	}
+
+	return 1;
+}
+
+static const char* nextSegment(const char* str)
+{
+	const char* ptr = strchr(str, '/');
+	return (ptr != NULL) ? ptr + 1 : NULL;
+}
@@ -0,0 +1,24 @@
+/**********************************************************************
+ * Premake - match.h
+ * File pattern matching for matchfiles() and matchrecursive().
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+int  match_path(const char* pattern, const char* path);
+int  match_scan(const char** patterns, int count, void (*cb)(const char*));
+int  match_getskipped();
+void match_setgitindex(int enabled);
+void match_setlistener(void (*listener)(const char* dir, const char** patterns, int count));
+void match_setthreads(int threads);
+void match_setuntracked(int enabled);
@@ -15,14 +15,20 @@
  * GNU General Public License in the file LICENSE.txt for details.
  **********************************************************************/
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "premake.h"
 #include "os.h"
 #include "platform.h"
 
-static char working[8192];
-static char forpart[8192];
+static THREAD_LOCAL char working[8192];
+static THREAD_LOCAL char forpart[8192];
+
+/* Each function that builds a path comes in two forms. The plain form
+ * returns a shared static buffer, which is overwritten by the next call.
+ * The _r form writes into a caller-owned buffer of at least 8192 bytes,
+ * and is safe to call from more than one thread at a time. */
 
 
 /************************************************************************
@@ -31,6 +37,20 @@ static char forpart[8192];
  ***********************************************************************/
 
 const char* path_absolute(const char* path)
+{
+	return path_absolute_r(path, working);
+}
+
+const char* path_absolute_r(const char* path, char* buffer)
+{
+	char cwd[8192];
+	platform_getcwd(cwd, 8192);
+	return path_absolute_in_r(cwd, path, buffer);
+}
+
+/* As path_absolute_r(), but relative to the absolute directory `dir`
+ * rather than the current one, which saves asking the system for it */
+const char* path_absolute_in_r(const char* dir, const char* path, char* buffer)
 {
 	char  relative[8192];
 	char* ptr;
@@ -44,9 +64,10 @@ const char* path_absolute(const char* path)
 	if (platform_isAbsolutePath(relative))
 		return path;
 
-	/* Figure out where I am currently */
-	platform_getcwd(working, 8192);
-	path_translateInPlace(working, "posix");
+	/* Start from the base directory */
+	if (buffer != dir)
+		strcpy(buffer, dir);
+	path_translateInPlace(buffer, "posix");
 
 	/* Split the target path and add it in piece by piece */
 	ptr = relative;
@@ -58,20 +79,20 @@ const char* path_absolute(const char* path)
 
 		if (matches(ptr, ".."))
 		{
-			char* sep = strrchr(working, '/');
+			char* sep = strrchr(buffer, '/');
 			if (sep != NULL)
 				*sep = '\0';
 		}
 		else if (!matches(ptr, "."))
 		{
-			strcat(working, "/");
-			strcat(working, ptr);
+			strcat(buffer, "/");
+			strcat(buffer, ptr);
 		}
 
 		ptr = (end != NULL) ? end + 1 : NULL;
 	}
 
-	return working;
+	return buffer;
 }
 
 
@@ -80,14 +101,28 @@ const char* path_absolute(const char* path)
  ***********************************************************************/
 
 const char* path_build(const char* from, const char* to)
+{
+	return path_build_r(from, to, working);
+}
+
+const char* path_build_r(const char* from, const char* to, char* buffer)
+{
+	char cwd[8192];
+	platform_getcwd(cwd, 8192);
+	return path_build_in_r(cwd, from, to, buffer);
+}
+
+/* As path_build_r(), with relative paths taken from the absolute
+ * directory `dir` rather than the current one */
+const char* path_build_in_r(const char* dir, const char* from, const char* to, char* buffer)
 {
 	char fromFull[8192];
 	char toFull[8192];
 	int start, i;
 
 	/* Retrieve the full path to both locations */
-	strcpy(fromFull, path_absolute(from));
-	strcpy(toFull,   path_absolute(to));
+	strcpy(fromFull, path_absolute_in_r(dir, from, buffer));
+	strcpy(toFull,   path_absolute_in_r(dir, to, buffer));
 
 	/* Append a separator to both */
 	strcat(fromFull, "/");
@@ -104,36 +139,39 @@ const char* path_build(const char* from, const char* to)
 	}
 
 	if (fromFull[i] == '\0' && toFull[i] == '\0')
-		return ".";
+	{
+		strcpy(buffer, ".");
+		return buffer;
+	}
 
 	/* Build the connecting path */
 	if (strlen(fromFull) - start > 0)
 	{
-		strcpy(working, "../");
+		strcpy(buffer, "../");
 		for (i = start; fromFull[i] != '\0'; ++i)
 		{
 			if (fromFull[i] == '/' && fromFull[i + 1] != '\0')
-				strcat(working, "../");
+				strcat(buffer, "../");
 		}
 	}
 	else
 	{
-		strcpy(working, "");
+		strcpy(buffer, "");
 	}
 
 	if (strlen(toFull) - start > 0)
 	{
-		strcat(working, toFull + start);
+		strcat(buffer, toFull + start);
 	}
 
 	/* Remove the trailing slash */
-	working[strlen(working) - 1] = '\0';
+	buffer[strlen(buffer) - 1] = '\0';
 
 	/* Make sure I return something */
-	if (strlen(working) == 0)
-		strcpy(working, ".");
+	if (strlen(buffer) == 0)
+		strcpy(buffer, ".");
 
-	return working;
+	return buffer;
 }
 
 
@@ -143,22 +181,27 @@ const char* path_build(const char* from, const char* to)
 
 const char* path_combine(const char* path0, const char* path1)
 {
-	strcpy(working, "");
+	return path_combine_r(path0, path1, working);
+}
+
+const char* path_combine_r(const char* path0, const char* path1, char* buffer)
+{
+	strcpy(buffer, "");
 
 	if (!matches(path0, ".") && !matches(path0, "./"))
-		strcat(working, path0);
+		strcat(buffer, path0);
 
-	path_translateInPlace(working, "posix");
+	path_translateInPlace(buffer, "posix");
 
 	if (!matches(path1, "") && !matches(path1, ".") && !matches(path1, "./"))
 	{
-		if (strlen(working) > 0 && working[strlen(working) - 1] != '/')
-			strcat(working, "/");
-		strcat(working, path1);
+		if (strlen(buffer) > 0 && buffer[strlen(buffer) - 1] != '/')
+			strcat(buffer, "/");
+		strcat(buffer, path1);
 	}
 
-	path_translateInPlace(working, "posix");
-	return working;
+	path_translateInPlace(buffer, "posix");
+	return buffer;
 }
 
 
@@ -171,9 +214,7 @@ int path_compare(const char* path0, const char* path1)
 	char abs0[8192];
 	char abs1[8192];
 
-	strcpy(abs0, path_absolute(path0));
-	strcpy(abs1, path_absolute(path1));
-	return matches(abs0, abs1);
+	return matches(path_absolute_r(path0, abs0), path_absolute_r(path1, abs1));
 }
 
 
@@ -194,7 +235,12 @@ char path_getseparator(const char* type)
 
 const char* path_getbasename(const char* path)
 {
-	const char* name = path_getname(path);
+	return path_getbasename_r(path, forpart);
+}
+
+const char* path_getbasename_r(const char* path, char* buffer)
+{
+	const char* name = path_getname_r(path, buffer);
 	char* ptr = strrchr(name, '.');
 	if (ptr != NULL)
 		*ptr = '\0';
@@ -208,21 +254,26 @@ const char* path_getextension(const char* path)
 }
 
 const char* path_getdir(const char* path)
+{
+	return path_getdir_r(path, forpart);
+}
+
+const char* path_getdir_r(const char* path, char* buffer)
 {
 	char* ptr;
 
 	if (path != NULL)
 	{
 		/* Convert path to neutral separators */
-		strcpy(forpart, path);
-		path_translateInPlace(forpart, "posix");
+		strcpy(buffer, path);
+		path_translateInPlace(buffer, "posix");
 
 		/* Now split at last separator */
-		ptr = strrchr(forpart, '/');
+		ptr = strrchr(buffer, '/');
 		if (ptr != NULL)
 		{
 			*ptr = '\0';
-			return forpart;
+			return buffer;
 		}
 	}
 
@@ -230,17 +281,22 @@ const char* path_getdir(const char* path)
 }
 
 const char* path_getname(const char* path)
+{
+	return path_getname_r(path, forpart);
+}
+
+const char* path_getname_r(const char* path, char* buffer)
 {
 	char* ptr;
 
 	if (path == NULL)
 		return NULL;
 
-	strcpy(forpart, path);
-	path_translateInPlace(forpart, "posix");
+	strcpy(buffer, path);
+	path_translateInPlace(buffer, "posix");
 
-	ptr = strrchr(forpart, '/');
-	ptr = (ptr != NULL) ? ++ptr : forpart;
+	ptr = strrchr(buffer, '/');
+	ptr = (ptr != NULL) ? ++ptr : buffer;
 	return ptr;
 }
 
@@ -251,23 +307,30 @@ const char* path_getname(const char* path)
 
 const char* path_join(const char* dir, const char* name, const char* ext)
 {
-	if (dir != NULL)
-		strcpy(working, dir);
-	else
-		strcpy(working, "");
+	return path_join_r(dir, name, ext, working);
+}
 
-	if (strlen(working) > 0)
-		strcat(working, "/");
+const char* path_join_r(const char* dir, const char* name, const char* ext, char* buffer)
+{
+	/* The directory may already be in the buffer, as when it came from
+	 * another path function */
+	if (dir == NULL)
+		strcpy(buffer, "");
+	else if (dir != buffer)
+		strcpy(buffer, dir);
+
+	if (strlen(buffer) > 0)
+		strcat(buffer, "/");
 	
-	strcat(working, name);
+	strcat(buffer, name);
 	
 	if (ext != NULL && strlen(ext) > 0)
 	{
-		strcat(working, ".");
-		strcat(working, ext);
+		strcat(buffer, ".");
+		strcat(buffer, ext);
 	}
 	
-	return working;
+	return buffer;
 }
 
 
@@ -277,10 +340,15 @@ const char* path_join(const char* dir, const char* name, const char* ext)
 
 const char* path_swapextension(const char* path, const char* from, const char* to)
 {
-	strcpy(working, path);
-	working[strlen(path) - strlen(from)] = '\0';
-	strcat(working, to);
-	return working;
+	return path_swapextension_r(path, from, to, working);
+}
+
+const char* path_swapextension_r(const char* path, const char* from, const char* to, char* buffer)
+{
+	strcpy(buffer, path);
+	buffer[strlen(path) - strlen(from)] = '\0';
+	strcat(buffer, to);
+	return buffer;
 }
 
 
@@ -290,9 +358,14 @@ const char* path_swapextension(const char* path, const char* from, const char* t
 
 const char* path_translate(const char* path, const char* type)
 {
-	strcpy(working, path);
-	path_translateInPlace(working, type);
-	return working;
+	return path_translate_r(path, type, working);
+}
+
+const char* path_translate_r(const char* path, const char* type, char* buffer)
+{
+	strcpy(buffer, path);
+	path_translateInPlace(buffer, type);
+	return buffer;
 }
 
 void path_translateInPlace(char* buffer, const char* type)
@@ -16,16 +16,27 @@
  **********************************************************************/
 
 const char* path_absolute(const char* path);
+const char* path_absolute_r(const char* path, char* buffer);
+const char* path_absolute_in_r(const char* dir, const char* path, char* buffer);
 const char* path_build(const char* from, const char* to);
+const char* path_build_r(const char* from, const char* to, char* buffer);
+const char* path_build_in_r(const char* dir, const char* from, const char* to, char* buffer);
 const char* path_combine(const char* path0, const char* path1);
+const char* path_combine_r(const char* path0, const char* path1, char* buffer);
 int         path_compare(const char* path0, const char* path1);
 const char* path_getbasename(const char* path);
+const char* path_getbasename_r(const char* path, char* buffer);
 const char* path_getextension(const char* path);
 const char* path_getdir(const char* path);
+const char* path_getdir_r(const char* path, char* buffer);
 const char* path_getname(const char* path);
+const char* path_getname_r(const char* path, char* buffer);
 char        path_getseparator(const char* type);
 const char* path_join(const char* dir, const char* name, const char* ext);
+const char* path_join_r(const char* dir, const char* name, const char* ext, char* buffer);
 const char* path_normalize(const char* path);
 const char* path_swapextension(const char* path, const char* from, const char* to);
+const char* path_swapextension_r(const char* path, const char* from, const char* to, char* buffer);
 const char* path_translate(const char* path, const char* type);
+const char* path_translate_r(const char* path, const char* type, char* buffer);
 void        path_translateInPlace(char* buffer, const char* type);
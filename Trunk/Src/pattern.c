@@ -0,0 +1,320 @@
+/**********************************************************************
+ * Premake - pattern.c
+ * Sets of file patterns, compiled for matching many names at once.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "premake.h"
+#include "os.h"
+#include "hash.h"
+#include "match.h"
+#include "pattern.h"
+
+static void addBits(Hash** hash, const char* key, int bits);
+static int  findBits(Hash* hash, const char* key);
+static const char* foldCase(const char* str, char* buffer);
+static PatternGroup* getGroup(PatternSet* set, const char* dir);
+static int  isLiteral(const char* str);
+static int  matchDir(const char* pattern, const char* dir);
+
+
+/************************************************************************
+ * Compile a list of patterns into a set. A pattern starting with "!"
+ * excludes the files it matches. Patterns are grouped by the directory
+ * part in front of the file name, so that each group is only checked
+ * against the directories it can match. Within a group, literal names
+ * and "*.ext" style names are looked up in a hash, leaving only the
+ * other wildcards to be tried one at a time.
+ ***********************************************************************/
+
+PatternSet* pattern_compile(const char** patterns, int count)
+{
+	PatternSet* set;
+	int i;
+
+	set = ALLOCT(PatternSet);
+	set->strings    = (char**)malloc(sizeof(char*) * (count > 0 ? count : 1));
+	set->numStrings = 0;
+	set->groups     = NULL;
+	set->numGroups  = 0;
+	set->paths      = NULL;
+	set->pathBits   = NULL;
+	set->numPaths   = 0;
+
+	for (i = 0; i < count; ++i)
+	{
+		PatternGroup* group;
+		const char* dir;
+		char* copy;
+		char* name;
+		char* sep;
+		int   bits;
+
+		const char* pattern = patterns[i];
+		bits = PATTERN_INCLUDE;
+		if (pattern[0] == '!')
+		{
+			bits = PATTERN_EXCLUDE;
+			pattern++;
+		}
+
+		copy = (char*)malloc(strlen(pattern) + 1);
+		strcpy(copy, pattern);
+		set->strings[set->numStrings++] = copy;
+
+		/* A "**" at the end matches files at any depth, so it can't be
+		 * split into a directory and a name */
+		sep  = strrchr(copy, '/');
+		name = (sep != NULL) ? sep + 1 : copy;
+		if (matches(name, "**"))
+		{
+			set->paths    = (const char**)realloc((void*)set->paths, sizeof(char*) * (set->numPaths + 1));
+			set->pathBits = (int*)realloc(set->pathBits, sizeof(int) * (set->numPaths + 1));
+			set->paths[set->numPaths]    = copy;
+			set->pathBits[set->numPaths] = bits;
+			set->numPaths++;
+			continue;
+		}
+
+		if (sep == NULL)
+		{
+			dir = "";
+		}
+		else if (sep == copy)
+		{
+			dir = "/";
+		}
+		else
+		{
+			*sep = '\0';
+			dir = copy;
+		}
+
+		group = getGroup(set, dir);
+		foldCase(name, name);
+
+		if (matches(name, "*"))
+		{
+			group->all |= bits;
+		}
+		else if (isLiteral(name))
+		{
+			addBits(&group->names, name, bits);
+		}
+		else if (name[0] == '*' && name[1] == '.' && isLiteral(name + 1))
+		{
+			addBits(&group->suffixes, name + 1, bits);
+		}
+		else
+		{
+			group->globs    = (const char**)realloc((void*)group->globs, sizeof(char*) * (group->numGlobs + 1));
+			group->globBits = (int*)realloc(group->globBits, sizeof(int) * (group->numGlobs + 1));
+			group->globs[group->numGlobs]    = name;
+			group->globBits[group->numGlobs] = bits;
+			group->numGlobs++;
+		}
+	}
+
+	return set;
+}
+
+
+/************************************************************************
+ * Find the groups that apply to files in a directory. The indices are
+ * stored in the groups array, which must have room for all of them,
+ * and the number found is returned.
+ ***********************************************************************/
+
+int pattern_select(PatternSet* set, const char* dir, int* groups)
+{
+	int count = 0;
+	int i;
+	for (i = 0; i < set->numGroups; ++i)
+	{
+		if (matchDir(set->groups[i].dir, dir))
+			groups[count++] = i;
+	}
+	return count;
+}
+
+
+/************************************************************************
+ * Test a file name against the selected groups. Returns PATTERN_INCLUDE
+ * and/or PATTERN_EXCLUDE for the kinds of patterns that matched.
+ ***********************************************************************/
+
+int pattern_test(PatternSet* set, const int* groups, int numGroups, const char* dir, const char* name)
+{
+	char buffer[8192];
+	char path[8192];
+	const char* ptr;
+	int bits, i, j;
+
+	/* Nothing on disk has a name this long; don't overflow on one */
+	if (strlen(name) >= sizeof(buffer))
+		return 0;
+	name = foldCase(name, buffer);
+
+	bits = 0;
+	for (i = 0; i < numGroups; ++i)
+	{
+		PatternGroup* group = &set->groups[groups[i]];
+		bits |= group->all;
+		bits |= findBits(group->names, name);
+		if (group->suffixes != NULL)
+		{
+			for (ptr = strchr(name, '.'); ptr != NULL; ptr = strchr(ptr + 1, '.'))
+				bits |= findBits(group->suffixes, ptr);
+		}
+
+		for (j = 0; j < group->numGlobs; ++j)
+		{
+			if ((bits & group->globBits[j]) == 0 && match_path(group->globs[j], name))
+				bits |= group->globBits[j];
+		}
+	}
+
+	/* Paths that don't fit can't be tested, and are skipped */
+	if (set->numPaths > 0 && strlen(dir) + strlen(name) + 1 < sizeof(path))
+	{
+		strcpy(path, dir);
+		if (strlen(path) > 0 && path[strlen(path) - 1] != '/')
+			strcat(path, "/");
+		strcat(path, name);
+
+		for (i = 0; i < set->numPaths; ++i)
+		{
+			if ((bits & set->pathBits[i]) == 0 && match_path(set->paths[i], path))
+				bits |= set->pathBits[i];
+		}
+	}
+
+	return bits;
+}
+
+
+void pattern_free(PatternSet* set)
+{
+	int i;
+
+	for (i = 0; i < set->numGroups; ++i)
+	{
+		hash_destroy(set->groups[i].names);
+		hash_destroy(set->groups[i].suffixes);
+		free((void*)set->groups[i].globs);
+		free(set->groups[i].globBits);
+	}
+
+	for (i = 0; i < set->numStrings; ++i)
+		free(set->strings[i]);
+
+	free(set->strings);
+	free(set->groups);
+	free((void*)set->paths);
+	free(set->pathBits);
+	free(set);
+}
+
+
+static void addBits(Hash** hash, const char* key, int bits)
+{
+	if (*hash == NULL)
+		*hash = hash_create();
+	bits |= findBits(*hash, key);
+	hash_insert(*hash, key, (void*)(long)bits);
+}
+
+
+static int findBits(Hash* hash, const char* key)
+{
+	return (hash != NULL) ? (int)(long)hash_find(hash, key) : 0;
+}
+
+
+/* Names compare without regard to case on Windows, as in match_path() */
+static const char* foldCase(const char* str, char* buffer)
+{
+#if defined(PLATFORM_WINDOWS)
+	int i;
+	for (i = 0; str[i] != '\0'; ++i)
+		buffer[i] = (char)tolower((unsigned char)str[i]);
+	buffer[i] = '\0';
+	return buffer;
+#else
+	(void)buffer;
+	return str;
+#endif
+}
+
+
+static PatternGroup* getGroup(PatternSet* set, const char* dir)
+{
+	PatternGroup* group;
+	int i;
+
+	for (i = 0; i < set->numGroups; ++i)
+	{
+		if (matches(set->groups[i].dir, dir))
+			return &set->groups[i];
+	}
+
+	set->groups = (PatternGroup*)realloc(set->groups, sizeof(PatternGroup) * (set->numGroups + 1));
+	group = &set->groups[set->numGroups++];
+	group->dir      = dir;
+	group->all      = 0;
+	group->names    = NULL;
+	group->suffixes = NULL;
+	group->globs    = NULL;
+	group->globBits = NULL;
+	group->numGlobs = 0;
+	return group;
+}
+
+
+static int isLiteral(const char* str)
+{
+	return (strpbrk(str, "*?[") == NULL);
+}
+
+
+static int matchDir(const char* pattern, const char* dir)
+{
+	char buffer[8192];
+	int  len;
+
+	/* Files at the top have no directory, which only "**" can match */
+	if (dir[0] == '\0')
+	{
+		if (pattern[0] == '\0' || matches(pattern, "**"))
+			return 1;
+	}
+	else if (match_path(pattern, dir))
+	{
+		return 1;
+	}
+
+	/* A "**" at the end can match no directories at all */
+	len = strlen(pattern);
+	if (len > 3 && len - 3 < (int)sizeof(buffer) && strcmp(pattern + len - 3, "/**") == 0)
+	{
+		memcpy(buffer, pattern, len - 3);
+		buffer[len - 3] = '\0';
+		return matchDir(buffer, dir);
+	}
+
+	return 0;
+}
@@ -0,0 +1,45 @@
+/**********************************************************************
+ * Premake - pattern.h
+ * Sets of file patterns, compiled for matching many names at once.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+enum { PATTERN_INCLUDE = 1, PATTERN_EXCLUDE = 2 };
+
+typedef struct tagPatternGroup
+{
+	const char* dir;
+	int    all;
+	Hash*  names;
+	Hash*  suffixes;
+	const char** globs;
+	int*   globBits;
+	int    numGlobs;
+} PatternGroup;
+
+typedef struct tagPatternSet
+{
+	char**        strings;
+	int           numStrings;
+	PatternGroup* groups;
+	int           numGroups;
+	const char**  paths;
+	int*          pathBits;
+	int           numPaths;
+} PatternSet;
+
+PatternSet* pattern_compile(const char** patterns, int count);
+int         pattern_select(PatternSet* set, const char* dir, int* groups);
+int         pattern_test(PatternSet* set, const int* groups, int numGroups, const char* dir, const char* name);
+void        pattern_free(PatternSet* set);
@@ -15,17 +15,45 @@
  * GNU General Public License in the file LICENSE.txt for details.
  **********************************************************************/
 
+struct PlatformLock;
+typedef struct PlatformLock* LockHandle;
+
+struct PlatformThread;
+typedef struct PlatformThread* ThreadHandle;
+
 int         platform_chdir(const char* path);
 int         platform_copyfile(const char* src, const char* dest);
+int         platform_copymode(const char* src, FILE* dest);
+int         platform_dirstamp(const char* path, char* stamp, long* changed);
 int         platform_findlib(const char* name, char* buffer, int len);
 int         platform_getcwd(char* buffer, int len);
 void        platform_getuuid(char* uuid);
 int         platform_isAbsolutePath(const char* path);
 int         platform_mask_close(MaskHandle data);
+const char* platform_mask_getentry(MaskHandle data);
 const char* platform_mask_getname(MaskHandle data);
 int         platform_mask_getnext(MaskHandle data);
+int         platform_mask_isdir(MaskHandle data);
 int         platform_mask_isfile(MaskHandle data);
 MaskHandle  platform_mask_open(const char* mask);
+MaskHandle  platform_mask_opensub(MaskHandle parent, const char* dir, const char* mask);
 int         platform_mkdir(const char* path);
 int         platform_remove(const char* path);
+int         platform_replacefile(const char* src, const char* dest);
 int         platform_rmdir(const char* path);
+
+LockHandle  platform_lock_create();
+int         platform_lock_destroy(LockHandle lock);
+int         platform_lock_acquire(LockHandle lock);
+int         platform_lock_release(LockHandle lock);
+int         platform_lock_wait(LockHandle lock);
+int         platform_lock_notify(LockHandle lock);
+
+ThreadHandle platform_thread_create(void (*func)(void*), void* arg);
+int          platform_thread_join(ThreadHandle thread);
+
+enum { WATCH_ENTRIES, WATCH_CONTENTS, WATCH_OVERFLOW };
+
+int         platform_watch_open();
+int         platform_watch_add(const char* path);
+int         platform_watch_read(int timeout, void (*cb)(int id, const char* name, int isdir, int kind));
@@ -22,12 +22,19 @@
 #include <stdlib.h>
 #include <dlfcn.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <fnmatch.h>
+#include <pthread.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
 #include "io.h"
 #include "path.h"
+#include "platform.h"
 #include "util.h"
 
 static char buffer[8192];
@@ -36,7 +43,24 @@ struct PlatformMaskData
 {
 	DIR* handle;
 	struct dirent* entry;
+	char* path;
 	char* mask;
+	char* name;
+	int   nameSize;
+	int   matchAll;
+};
+
+struct PlatformLock
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+};
+
+struct PlatformThread
+{
+	pthread_t handle;
+	void (*func)(void*);
+	void* arg;
 };
 
 
@@ -53,6 +77,17 @@ int platform_copyfile(const char* src, const char* dest)
 }
 
 
+/* Give an open file the permissions of an existing one. A new file
+ * keeps the ones it was created with. */
+int platform_copymode(const char* src, FILE* dest)
+{
+	struct stat sb;
+	if (stat(src, &sb) != 0)
+		return 1;
+	return (fchmod(fileno(dest), sb.st_mode & 07777) == 0);
+}
+
+
 static int findLibHelper(const char* lib, const char* path)
 {
 	struct stat sb;
@@ -69,6 +104,33 @@ static int findLibHelper(const char* lib, const char* path)
 	return 0;
 }
 
+/* Describe the state of a directory in a way that changes whenever an
+ * entry is added, removed, or renamed, or the directory is replaced.
+ * Also returns the time of the most recent change, in seconds. */
+int platform_dirstamp(const char* path, char* stamp, long* changed)
+{
+	struct stat info;
+	long mtimeNsec, ctimeNsec;
+
+	if (stat(path, &info) != 0 || !S_ISDIR(info.st_mode))
+		return 0;
+
+#if defined(__APPLE__)
+	mtimeNsec = (long)info.st_mtimespec.tv_nsec;
+	ctimeNsec = (long)info.st_ctimespec.tv_nsec;
+#else
+	mtimeNsec = (long)info.st_mtim.tv_nsec;
+	ctimeNsec = (long)info.st_ctim.tv_nsec;
+#endif
+
+	sprintf(stamp, "%ld.%09ld %ld.%09ld %lu %lu",
+		(long)info.st_mtime, mtimeNsec, (long)info.st_ctime, ctimeNsec,
+		(unsigned long)info.st_ino, (unsigned long)info.st_dev);
+	*changed = (long)((info.st_mtime > info.st_ctime) ? info.st_mtime : info.st_ctime);
+	return 1;
+}
+
+
 int platform_findlib(const char* name, char* buffer, int len)
 {
 	FILE* file;
@@ -136,33 +198,46 @@ int platform_mask_close(MaskHandle data)
 {
 	if (data->handle != NULL)
 		closedir(data->handle);
+	free(data->path);
 	free(data->mask);
+	free(data->name);
 	free(data);
 	return 1;
 }
 
 
+const char* platform_mask_getentry(MaskHandle data)
+{
+	return data->entry->d_name;
+}
+
+
 const char* platform_mask_getname(MaskHandle data)
 {
-	strcpy(buffer, path_getdir(data->mask));
-	if (strlen(buffer) > 0)
-		strcat(buffer, "/");
-	strcat(buffer, data->entry->d_name);
-	return buffer;
+	int len = strlen(data->path) + strlen(data->entry->d_name) + 2;
+	if (len > data->nameSize)
+	{
+		data->nameSize = len;
+		data->name = (char*)realloc(data->name, len);
+	}
+
+	strcpy(data->name, data->path);
+	if (strlen(data->name) > 0 && !endsWith(data->name, "/"))
+		strcat(data->name, "/");
+	strcat(data->name, data->entry->d_name);
+	return data->name;
 }
 
 
 int platform_mask_getnext(MaskHandle data)
 {
-	const char* mask = path_getname(data->mask);
-
 	if (data->handle == NULL)
 		return 0;
 		
 	data->entry = readdir(data->handle);
 	while (data->entry != NULL)
 	{
-		if (fnmatch(mask, data->entry->d_name, 0) == 0)
+		if (data->matchAll || fnmatch(data->mask, data->entry->d_name, 0) == 0)
 			return 1;
 		data->entry = readdir(data->handle);
 	}
@@ -170,27 +245,126 @@ int platform_mask_getnext(MaskHandle data)
 }
 
 
-int platform_mask_isfile(MaskHandle data)
+/* Most file systems report the entry type with the directory listing;
+ * only ask the file system when it doesn't know, or for a symbolic
+ * link, which is classified by what it points to */
+static int getEntryMode(MaskHandle data, mode_t* mode)
 {
 	struct stat info;
-	if (stat(platform_mask_getname(data), &info) == 0)
+
+#if defined(DT_UNKNOWN)
+	switch (data->entry->d_type)
 	{
-		return S_ISREG(info.st_mode);
+	case DT_REG:
+		*mode = S_IFREG;
+		return 1;
+	case DT_DIR:
+		*mode = S_IFDIR;
+		return 1;
+	case DT_UNKNOWN:
+	case DT_LNK:
+		break;
+	default:
+		*mode = 0;
+		return 1;
 	}
-	return 0;
+#endif
+
+	if (fstatat(dirfd(data->handle), data->entry->d_name, &info, 0) != 0)
+		return 0;
+	*mode = info.st_mode;
+	return 1;
 }
 
 
-MaskHandle platform_mask_open(const char* mask)
+int platform_mask_isdir(MaskHandle data)
+{
+	mode_t mode;
+	return (getEntryMode(data, &mode) && S_ISDIR(mode));
+}
+
+
+int platform_mask_isfile(MaskHandle data)
+{
+	mode_t mode;
+	return (getEntryMode(data, &mode) && S_ISREG(mode));
+}
+
+
+static MaskHandle newMask(int fd, const char* path, const char* mask)
 {
-	const char* path = path_getdir(mask);
-	if (strlen(path) == 0)
-		path = ".";
-		
 	MaskHandle data = ALLOCT(struct PlatformMaskData);
-	data->handle = opendir(path);
+	data->handle = NULL;
+	if (fd >= 0)
+	{
+		data->handle = fdopendir(fd);
+		if (data->handle == NULL)
+			close(fd);
+	}
+
+	data->entry = NULL;
+	data->path = (char*)malloc(strlen(path) + 1);
+	strcpy(data->path, path);
 	data->mask = (char*)malloc(strlen(mask) + 1);
 	strcpy(data->mask, mask);
+	data->name = NULL;
+	data->nameSize = 0;
+	data->matchAll = (strcmp(mask, "*") == 0);
+	return data;
+}
+
+
+MaskHandle platform_mask_open(const char* mask)
+{
+	const char* name = strrchr(mask, '/');
+	char* path;
+	MaskHandle data;
+	int fd;
+
+	/* Split the directory from the file mask */
+	path = (char*)malloc(strlen(mask) + 1);
+	strcpy(path, mask);
+	if (name == mask)
+	{
+		/* A mask at the top of the file system keeps its separator */
+		path[1] = '\0';
+		name++;
+	}
+	else if (name != NULL)
+	{
+		path[name - mask] = '\0';
+		name++;
+	}
+	else
+	{
+		path[0] = '\0';
+		name = mask;
+	}
+
+	fd = open(strlen(path) > 0 ? path : ".", O_RDONLY | O_DIRECTORY);
+	data = newMask(fd, path, name);
+	free(path);
+	return data;
+}
+
+
+MaskHandle platform_mask_opensub(MaskHandle parent, const char* dir, const char* mask)
+{
+	char* path;
+	MaskHandle data;
+	int fd = -1;
+
+	path = (char*)malloc(strlen(parent->path) + strlen(dir) + 2);
+	strcpy(path, parent->path);
+	if (strlen(path) > 0 && !endsWith(path, "/"))
+		strcat(path, "/");
+	strcat(path, dir);
+
+	/* Open relative to the parent, rather than resolving the path again */
+	if (parent->handle != NULL)
+		fd = openat(dirfd(parent->handle), dir, O_RDONLY | O_DIRECTORY);
+	data = newMask(fd, path, mask);
+	free(path);
 	return data;
 }
 
@@ -208,6 +382,12 @@ int platform_remove(const char* path)
 }
 
 
+int platform_replacefile(const char* src, const char* dest)
+{
+	return (rename(src, dest) == 0);
+}
+
+
 int platform_rmdir(const char* path)
 {
 	strcpy(buffer, "rm -rf ");
@@ -215,4 +395,155 @@ int platform_rmdir(const char* path)
 	return (system(buffer) == 0);
 }
 
+
+
+/**********************************************************************
+ * Locks and threads, used by the parallel directory walker. Each lock
+ * carries a condition so that waiting threads can be woken on change.
+ **********************************************************************/
+
+LockHandle platform_lock_create()
+{
+	LockHandle lock = ALLOCT(struct PlatformLock);
+	pthread_mutex_init(&lock->mutex, NULL);
+	pthread_cond_init(&lock->cond, NULL);
+	return lock;
+}
+
+
+int platform_lock_destroy(LockHandle lock)
+{
+	pthread_cond_destroy(&lock->cond);
+	pthread_mutex_destroy(&lock->mutex);
+	free(lock);
+	return 1;
+}
+
+
+int platform_lock_acquire(LockHandle lock)
+{
+	return (pthread_mutex_lock(&lock->mutex) == 0);
+}
+
+
+int platform_lock_release(LockHandle lock)
+{
+	return (pthread_mutex_unlock(&lock->mutex) == 0);
+}
+
+
+int platform_lock_wait(LockHandle lock)
+{
+	return (pthread_cond_wait(&lock->cond, &lock->mutex) == 0);
+}
+
+
+int platform_lock_notify(LockHandle lock)
+{
+	return (pthread_cond_broadcast(&lock->cond) == 0);
+}
+
+
+static void* threadMain(void* arg)
+{
+	ThreadHandle thread = (ThreadHandle)arg;
+	thread->func(thread->arg);
+	return NULL;
+}
+
+
+ThreadHandle platform_thread_create(void (*func)(void*), void* arg)
+{
+	ThreadHandle thread = ALLOCT(struct PlatformThread);
+	thread->func = func;
+	thread->arg  = arg;
+	if (pthread_create(&thread->handle, NULL, threadMain, thread) != 0)
+	{
+		free(thread);
+		return NULL;
+	}
+	return thread;
+}
+
+
+int platform_thread_join(ThreadHandle thread)
+{
+	pthread_join(thread->handle, NULL);
+	free(thread);
+	return 1;
+}
+
+
+
+/**********************************************************************
+ * File system change notification, for --watch. Only Linux (inotify)
+ * is supported at the moment.
+ **********************************************************************/
+
+static int watchHandle = -1;
+
+int platform_watch_open()
+{
+#if defined(__linux__)
+	watchHandle = inotify_init();
+	return (watchHandle >= 0);
+#else
+	return 0;
+#endif
+}
+
+
+int platform_watch_add(const char* path)
+{
+#if defined(__linux__)
+	return inotify_add_watch(watchHandle, path, IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+		IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+#else
+	return -1;
+#endif
+}
+
+
+/* Wait up to timeout milliseconds (or forever, if negative) for changes,
+ * and pass each one to the callback. Returns the number of changes, or
+ * -1 if changes can't be read */
+int platform_watch_read(int timeout, void (*cb)(int id, const char* name, int isdir, int kind))
+{
+#if defined(__linux__)
+	long aligned[4096];
+	char* events = (char*)aligned;
+	struct pollfd poller;
+	int len, pos, count;
+
+	poller.fd = watchHandle;
+	poller.events = POLLIN;
+	poller.revents = 0;
+	count = poll(&poller, 1, timeout);
+	if (count <= 0)
+		return count;
+
+	len = read(watchHandle, events, sizeof(aligned));
+	if (len < 0)
+		return -1;
+
+	count = 0;
+	for (pos = 0; pos < len; pos += sizeof(struct inotify_event) + ((struct inotify_event*)(events + pos))->len)
+	{
+		struct inotify_event* event = (struct inotify_event*)(events + pos);
+		const char* name = (event->len > 0) ? event->name : "";
+
+		if (event->mask & IN_Q_OVERFLOW)
+			cb(-1, name, 0, WATCH_OVERFLOW);
+		else if (event->mask & IN_CLOSE_WRITE)
+			cb(event->wd, name, 0, WATCH_CONTENTS);
+		else if (!(event->mask & IN_IGNORED))
+			cb(event->wd, name, (event->mask & IN_ISDIR) != 0, WATCH_ENTRIES);
+		count++;
+	}
+	return count;
+#else
+	return -1;
+#endif
+}
+
 #endif
@@ -18,6 +18,7 @@
 #include "os.h"
 #if defined(PLATFORM_WINDOWS)
 
+#include <stdio.h>
 #include <stdlib.h>
 #include "io.h"
 #include "path.h"
@@ -32,11 +33,25 @@ static char buffer[8192];
 struct PlatformMaskData
 {
 	char* maskPath;
+	char* name;
 	HANDLE handle;
 	WIN32_FIND_DATA entry;
 	int isFirst;
 };
 
+struct PlatformLock
+{
+	CRITICAL_SECTION   section;
+	CONDITION_VARIABLE cond;
+};
+
+struct PlatformThread
+{
+	HANDLE handle;
+	void (*func)(void*);
+	void* arg;
+};
+
 static int (__stdcall *CoCreateGuid)(char*) = NULL;
 static BOOL (__stdcall *GetUserName_)(LPTSTR,LPDWORD) = NULL;
 
@@ -53,6 +68,40 @@ int platform_copyfile(const char* src, const char* dest)
 }
 
 
+/* Windows files don't carry POSIX permissions, so there is nothing to copy */
+int platform_copymode(const char* src, FILE* dest)
+{
+	(void)src;
+	(void)dest;
+	return 1;
+}
+
+
+/* Describe the state of a directory in a way that changes whenever an
+ * entry is added, removed, or renamed, or the directory is replaced.
+ * Also returns the time of the most recent change, in seconds. */
+int platform_dirstamp(const char* path, char* stamp, long* changed)
+{
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	ULARGE_INTEGER time;
+
+	if (!GetFileAttributesEx(path, GetFileExInfoStandard, &info))
+		return 0;
+	if ((info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+		return 0;
+
+	sprintf(stamp, "%lu.%lu %lu.%lu",
+		info.ftLastWriteTime.dwHighDateTime, info.ftLastWriteTime.dwLowDateTime,
+		info.ftCreationTime.dwHighDateTime, info.ftCreationTime.dwLowDateTime);
+
+	/* FILETIME counts 100ns ticks since 1601 */
+	time.LowPart  = info.ftLastWriteTime.dwLowDateTime;
+	time.HighPart = info.ftLastWriteTime.dwHighDateTime;
+	*changed = (long)(time.QuadPart / 10000000 - 11644473600);
+	return 1;
+}
+
+
 int platform_findlib(const char* name, char* buffer, int len)
 {
 	HMODULE hDll = LoadLibrary(name);
@@ -98,18 +147,25 @@ int platform_mask_close(MaskHandle data)
 	if (data->handle != INVALID_HANDLE_VALUE)
 		FindClose(data->handle);
 	free(data->maskPath);
+	free(data->name);
 	free(data);
 	return 1;
 }
 
 
+const char* platform_mask_getentry(MaskHandle data)
+{
+	return data->entry.cFileName;
+}
+
+
 const char* platform_mask_getname(MaskHandle data)
 {
-	strcpy(buffer, data->maskPath);
-	if (strlen(buffer) > 0)
-		strcat(buffer, "/");
-	strcat(buffer, data->entry.cFileName);
-	return buffer;
+	strcpy(data->name, data->maskPath);
+	if (strlen(data->name) > 0)
+		strcat(data->name, "/");
+	strcat(data->name, data->entry.cFileName);
+	return data->name;
 }
 
 
@@ -130,6 +186,12 @@ int platform_mask_getnext(MaskHandle data)
 }
 
 
+int platform_mask_isdir(MaskHandle data)
+{
+	return (data->entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+}
+
+
 int platform_mask_isfile(MaskHandle data)
 {
 	return (data->entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0;
@@ -138,17 +200,53 @@ int platform_mask_isfile(MaskHandle data)
 
 MaskHandle platform_mask_open(const char* mask)
 {
-	const char* path = path_getdir(mask);
+	const char* ptr;
+	char* sep;
+	int len;
 
 	MaskHandle data = ALLOCT(struct PlatformMaskData);
 	data->handle = FindFirstFile(mask, &data->entry);
-	data->maskPath = (char*)malloc(strlen(path) + 1);
-	strcpy(data->maskPath, path);
+
+	/* Split off the directory here, rather than with path_getdir(), so
+	 * that masks may be opened from more than one thread */
+	ptr = mask + strlen(mask);
+	while (ptr > mask && *(ptr - 1) != '/' && *(ptr - 1) != '\\')
+		ptr--;
+	len = (ptr > mask) ? (ptr - mask - 1) : 0;
+	data->maskPath = (char*)malloc(len + 1);
+	strncpy(data->maskPath, mask, len);
+	data->maskPath[len] = '\0';
+	for (sep = data->maskPath; *sep != '\0'; ++sep)
+	{
+		if (*sep == '\\')
+			*sep = '/';
+	}
+
+	data->name = (char*)malloc(len + MAX_PATH + 2);
 	data->isFirst  = 1;
 	return data;
 }
 
 
+MaskHandle platform_mask_opensub(MaskHandle parent, const char* dir, const char* mask)
+{
+	char* path;
+	MaskHandle data;
+
+	/* FindFirstFile() has no handle-relative form; build the full mask */
+	path = (char*)malloc(strlen(parent->maskPath) + strlen(dir) + strlen(mask) + 3);
+	strcpy(path, parent->maskPath);
+	if (strlen(path) > 0)
+		strcat(path, "/");
+	strcat(path, dir);
+	strcat(path, "/");
+	strcat(path, mask);
+	data = platform_mask_open(path);
+	free(path);
+	return data;
+}
+
+
 int platform_mkdir(const char* path)
 {
 	return CreateDirectory(path, NULL);
@@ -162,6 +260,12 @@ int platform_remove(const char* path)
 }
 
 
+int platform_replacefile(const char* src, const char* dest)
+{
+	return MoveFileEx(src, dest, MOVEFILE_REPLACE_EXISTING);
+}
+
+
 int platform_rmdir(const char* path)
 {
 	WIN32_FIND_DATA data;
@@ -198,4 +302,110 @@ int platform_rmdir(const char* path)
 	return 1;
 }
 
+
+
+/**********************************************************************
+ * Locks and threads, used by the parallel directory walker. Each lock
+ * carries a condition so that waiting threads can be woken on change.
+ **********************************************************************/
+
+LockHandle platform_lock_create()
+{
+	LockHandle lock = ALLOCT(struct PlatformLock);
+	InitializeCriticalSection(&lock->section);
+	InitializeConditionVariable(&lock->cond);
+	return lock;
+}
+
+
+int platform_lock_destroy(LockHandle lock)
+{
+	DeleteCriticalSection(&lock->section);
+	free(lock);
+	return 1;
+}
+
+
+int platform_lock_acquire(LockHandle lock)
+{
+	EnterCriticalSection(&lock->section);
+	return 1;
+}
+
+
+int platform_lock_release(LockHandle lock)
+{
+	LeaveCriticalSection(&lock->section);
+	return 1;
+}
+
+
+int platform_lock_wait(LockHandle lock)
+{
+	return SleepConditionVariableCS(&lock->cond, &lock->section, INFINITE);
+}
+
+
+int platform_lock_notify(LockHandle lock)
+{
+	WakeAllConditionVariable(&lock->cond);
+	return 1;
+}
+
+
+static DWORD WINAPI threadMain(LPVOID arg)
+{
+	ThreadHandle thread = (ThreadHandle)arg;
+	thread->func(thread->arg);
+	return 0;
+}
+
+
+ThreadHandle platform_thread_create(void (*func)(void*), void* arg)
+{
+	ThreadHandle thread = ALLOCT(struct PlatformThread);
+	thread->func = func;
+	thread->arg  = arg;
+	thread->handle = CreateThread(NULL, 0, threadMain, thread, 0, NULL);
+	if (thread->handle == NULL)
+	{
+		free(thread);
+		return NULL;
+	}
+	return thread;
+}
+
+
+int platform_thread_join(ThreadHandle thread)
+{
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+	free(thread);
+	return 1;
+}
+
+
+
+/**********************************************************************
+ * File system change notification, for --watch. Not yet supported
+ * on Windows.
+ **********************************************************************/
+
+int platform_watch_open()
+{
+	return 0;
+}
+
+
+int platform_watch_add(const char* path)
+{
+	return -1;
+}
+
+
+int platform_watch_read(int timeout, void (*cb)(int id, const char* name, int isdir, int kind))
+{
+	return -1;
+}
+
 #endif
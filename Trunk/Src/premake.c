@@ -16,10 +16,19 @@
  **********************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "premake.h"
 #include "arg.h"
+#include "dircache.h"
+#include "gitindex.h"
+#include "jobs.h"
+#include "match.h"
 #include "os.h"
 #include "script.h"
+#include "snapshot.h"
+#include "state.h"
+#include "watch.h"
 #include "Lua/lua.h"
 
 #include "gnu.h"
@@ -39,9 +48,17 @@ const char* g_dotnet;
 int         g_verbose;
 int         g_hasScript;
 
+static int  watching;
+static const char* fromModel;
+static char scriptName[8192];
+static char loadModel[8192];
+static char saveModel[8192];
+
 static int  preprocess();
 static int  postprocess();
+static void reportIgnored();
 static void showUsage();
+static void watchForChanges();
 
 int clean();
 
@@ -65,6 +82,7 @@ int main(int argc, char** argv)
 	g_cc       = NULL;
 	g_dotnet   = NULL;
 	g_verbose  = 0;
+	watching   = 0;
 
 	/* Process any options that will effect script processing */
 	arg_set(argc, argv);
@@ -74,13 +92,23 @@ int main(int argc, char** argv)
 	/* chdir() to the directory containing the project script, so that
 	 * relative paths may be used in the script */
 	io_chdir(path_getdir(g_filename));
+	g_filename = path_getname_r(g_filename, scriptName);
+
+	/* A saved model stands in for the script, which is not run. Load it
+	 * from the script directory so its paths resolve the same way */
+	if (fromModel != NULL && !snapshot_load(fromModel))
+		return 1;
 
 	/* Now run the script */
-	g_hasScript = script_run(g_filename);
-	if (g_hasScript < 0)
+	if (fromModel == NULL)
 	{
-		puts("** Script failed to run, ending.");
-		return 1;
+		g_hasScript = script_run(g_filename);
+		if (g_hasScript < 0)
+		{
+			puts("** Script failed to run, ending.");
+			return 1;
+		}
+		reportIgnored();
 	}
 
 	/* Process any options that depend on the script output */
@@ -88,10 +116,16 @@ int main(int argc, char** argv)
 	if (!postprocess())
 		return 1;
 
+	/* Keep the generated files up to date until interrupted */
+	if (watching && g_hasScript)
+		watchForChanges();
+
 	/* All done */
 	if (g_hasScript)
 		script_close();
 	prj_close();
+	dircache_close();
+	gitindex_close();
 	return 0;
 }
 
@@ -125,6 +159,91 @@ static int preprocess()
 				return 1;
 			}
 		}
+		else if (matches(flag, "--from-model"))
+		{
+			fromModel = arg_getflagarg();
+			if (fromModel == NULL)
+			{
+				puts("** Usage: --from-model filename");
+				puts(HELP_MSG);
+				return 1;
+			}
+
+			/* Relative to where premake was started, not the script */
+			strcpy(loadModel, path_absolute(fromModel));
+			fromModel = loadModel;
+		}
+		else if (matches(flag, "--save-model"))
+		{
+			const char* filename = arg_getflagarg();
+			if (filename == NULL)
+			{
+				puts("** Usage: --save-model filename");
+				puts(HELP_MSG);
+				return 1;
+			}
+
+			/* Relative to where premake was started, not the script */
+			strcpy(saveModel, path_absolute(filename));
+		}
+		else if (matches(flag, "--dircache"))
+		{
+			const char* filename = arg_getflagarg();
+			if (filename == NULL)
+			{
+				puts("** Usage: --dircache filename");
+				puts(HELP_MSG);
+				return 1;
+			}
+			dircache_open(filename);
+		}
+		else if (matches(flag, "--watch"))
+		{
+			if (!watch_open())
+			{
+				puts("** --watch is not supported on this platform");
+				puts(HELP_MSG);
+				return 1;
+			}
+			watching = 1;
+			match_setlistener(watch_adddir);
+		}
+		else if (matches(flag, "--gitindex"))
+		{
+			match_setgitindex(1);
+		}
+		else if (matches(flag, "--include-untracked"))
+		{
+			match_setuntracked(1);
+		}
+		else if (matches(flag, "--jobs"))
+		{
+			const char* jobs = arg_getflagarg();
+			if (jobs == NULL || atoi(jobs) < 1)
+			{
+				puts("** Usage: --jobs count");
+				puts(HELP_MSG);
+				return 1;
+			}
+			jobs_setcount(atoi(jobs));
+		}
+		else if (matches(flag, "--threads"))
+		{
+			const char* threads = arg_getflagarg();
+			if (threads == NULL || atoi(threads) < 1)
+			{
+				puts("** Usage: --threads count");
+				puts(HELP_MSG);
+				return 1;
+			}
+			match_setthreads(atoi(threads));
+		}
+		else if (matches(flag, "--verbose"))
+		{
+			/* Needed while the script runs, as well as by the targets */
+			g_verbose = 1;
+			io_setverbose(1);
+		}
 		else if (matches(flag, "--version"))
 		{
 			printf("premake (Premake Build Script Generator) %s\n", VERSION);
@@ -133,6 +252,10 @@ static int preprocess()
 		flag = arg_getflag();
 	}
 
+	/* Watch mode keeps the directory listings in memory between runs */
+	if (watching)
+		dircache_open(NULL);
+
 	return 1;
 }
 
@@ -148,34 +271,45 @@ static int postprocess()
 	const char* flag = arg_getflag();
 	while (flag != NULL)
 	{
-		if (g_hasScript && !script_export())
-			return 0;
-
 		if (matches(flag, "--help"))
 		{
+			if (g_hasScript && !script_export())
+				return 0;
 			showUsage();
 		}
 		else if (matches(flag, "--version"))
 		{
 			/* ignore quietly */
 		}
-		else if (matches(flag, "--file"))
+		else if (matches(flag, "--file") || matches(flag, "--from-model"))
+		{
+			arg_getflagarg();
+		}
+		else if (matches(flag, "--save-model") && (g_hasScript || fromModel != NULL))
 		{
 			arg_getflagarg();
+			if (g_hasScript && !script_export())
+				return 0;
+			if (!snapshot_save(saveModel))
+				return 0;
 		}
 		else
 		{
-			if (!g_hasScript)
+			if (g_hasScript)
 			{
-				if (!noScriptWarning)
-				{
-					puts("** No Premake script found!");
-					noScriptWarning = 1;
-				}
+				script_docommand(flag);
 			}
-			else
+			else if (fromModel != NULL)
 			{
-				script_docommand(flag);
+				/* Without a script, only the built-in commands are known */
+				const char* cmd = (strncmp(flag, "--", 2) == 0) ? flag + 2 : flag;
+				if (!onCommand(cmd, arg_getflagarg()))
+					return 0;
+			}
+			else if (!noScriptWarning)
+			{
+				puts("** No Premake script found!");
+				noScriptWarning = 1;
 			}
 		}
 
@@ -187,50 +321,154 @@ static int postprocess()
 
 
 /**********************************************************************
- * Default command handler
+ * Watch mode: rerun the scripts and regenerate whenever a script
+ * changes, or files are added to or removed from a searched directory
  **********************************************************************/
 
-int onCommand(const char* cmd, const char* arg)
+static void watchScripts()
 {
-	if (matches(cmd, "target"))
+	const char* filename;
+	int i;
+
+	for (i = 0; (filename = script_getloaded(i)) != NULL; ++i)
+		watch_addscript(filename);
+}
+
+static void watchForChanges()
+{
+	char cwd[8192];
+	strcpy(cwd, io_getcwd());
+
+	watchScripts();
+	puts("Watching for changes (press Ctrl+C to stop)...");
+	fflush(stdout);
+
+	while (watch_wait())
 	{
-		if (matches(arg, "gnu"))
-		{
-			return gnu_generate();
-		}
-		else if (matches(arg, "monodev") || matches(arg, "md"))
-		{
-			return sharpdev_generate("monodev");
-		}
-		else if (matches(arg, "sharpdev") || matches(arg, "sd"))
-		{
-			return sharpdev_generate("sharpdev");
-		}
-		else if (matches(arg, "vs6"))
-		{
-			return vs6_generate();
-		}
-		else if (matches(arg, "vs2002") || matches(arg, "vs7"))
-		{
-			return vs2002_generate(2002);
-		}
-		else if (matches(arg, "vs2003"))
-		{
-			return vs2002_generate(2003);
-		}
-		else if (matches(arg, "vs2005"))
+		puts("Changes detected, regenerating...");
+		io_chdir(cwd);
+		watch_reset();
+
+		if (g_hasScript > 0)
+			script_close();
+
+		g_hasScript = script_run(g_filename);
+		if (g_hasScript > 0)
 		{
-			return vs2005_generate();
+			reportIgnored();
+			arg_reset();
+			postprocess();
 		}
 		else
 		{
-			printf("** Unrecognized target '%s'\n", arg);
+			puts("** Script failed to run, waiting for changes.");
+		}
+
+		watchScripts();
+		fflush(stdout);
+	}
+
+	puts("** Unable to watch for changes, ending.");
+}
+
+
+/**********************************************************************
+ * In verbose mode, say how many directories were left out of file
+ * searches by ignore rules during the last script run
+ **********************************************************************/
+
+static void reportIgnored()
+{
+	static int reported = 0;
+	int skipped = match_getskipped();
+
+	if (g_verbose && skipped > reported)
+		printf("Ignored %d directories while searching for files\n", skipped - reported);
+	reported = skipped;
+}
+
+
+/**********************************************************************
+ * Run the generator for a single target
+ **********************************************************************/
+
+static int generate(const char* target)
+{
+	if (matches(target, "gnu"))
+	{
+		return gnu_generate();
+	}
+	else if (matches(target, "monodev") || matches(target, "md"))
+	{
+		return sharpdev_generate("monodev");
+	}
+	else if (matches(target, "sharpdev") || matches(target, "sd"))
+	{
+		return sharpdev_generate("sharpdev");
+	}
+	else if (matches(target, "vs6"))
+	{
+		return vs6_generate();
+	}
+	else if (matches(target, "vs2002") || matches(target, "vs7"))
+	{
+		return vs2002_generate(2002);
+	}
+	else if (matches(target, "vs2003"))
+	{
+		return vs2002_generate(2003);
+	}
+	else if (matches(target, "vs2005"))
+	{
+		return vs2005_generate();
+	}
+	else
+	{
+		printf("** Unrecognized target '%s'\n", target);
+		return 0;
+	}
+}
+
+
+/**********************************************************************
+ * Default command handler
+ **********************************************************************/
+
+int onCommand(const char* cmd, const char* arg)
+{
+	if (matches(cmd, "target"))
+	{
+		char targets[512];
+		char* target;
+		char* next;
+		int result;
+
+		if (g_hasScript && !script_export())
 			return 0;
+
+		/* A comma-separated list of targets is generated from the one
+		 * exported model, in the order given */
+		strncpy(targets, (arg != NULL) ? arg : "", sizeof(targets) - 1);
+		targets[sizeof(targets) - 1] = '\0';
+		for (target = targets; target != NULL; target = next)
+		{
+			next = strchr(target, ',');
+			if (next != NULL)
+				*(next++) = '\0';
+
+			state_open(target);
+			result = generate(target);
+			state_close(result);
+			if (!result)
+				return 0;
 		}
+		return 1;
 	}
 
 	else if (matches(cmd, "clean"))
 	{
+		if (g_hasScript && !script_export())
+			return 0;
 		return clean();
 	}
 
@@ -245,6 +483,7 @@ int onCommand(const char* cmd, const char* arg)
 	else if (matches(cmd, "verbose"))
 	{
 		g_verbose = 1;
+		io_setverbose(1);
 	}
 
 	return 1;
@@ -264,9 +503,13 @@ void showUsage()
 	printf("%s %s\n", LUA_VERSION, LUA_COPYRIGHT);
 	puts("");
 	puts(" --file name       Process the specified premake script file");
+	puts(" --from-model file Generate from a model saved with --save-model, instead");
+	puts("                   of running the script");
+	puts(" --save-model file Save the exported project model, to generate from later");
 	puts("");
 	puts(" --clean           Remove all binaries and build scripts");
 	puts(" --verbose       Generate verbose makefiles (where applicable)");
+	puts(" --watch           Regenerate whenever scripts or searched directories change");
 	puts("");
 	puts(" --cc name         Choose a C/C++ compiler, if supported by target; one of:");
 	puts("      gcc       GNU gcc compiler");
@@ -278,6 +521,12 @@ void showUsage()
 	puts("      mono2     Mono .NET 2.0 (gmcs)");
 	puts("      pnet      Portable.NET (cscc)");
 	puts("");
+	puts(" --dircache name   Cache directory listings in the specified file");
+	puts(" --gitindex        Find files tracked by Git from its index, without searching");
+	puts(" --include-untracked  With --gitindex, also search for untracked files");
+	puts(" --jobs count      Number of threads used to write package files (default 1)");
+	puts(" --threads count   Number of threads used to search for files (default 1)");
+	puts("");
 	puts(" --os name         Generate files for different operating system; one of:");
 	puts("      bsd       OpenBSD, NetBSD, or FreeBSD");
 	puts("      linux     Linux");
@@ -292,6 +541,7 @@ void showUsage()
 	puts("      vs2002    Microsoft Visual Studio 2002");
 	puts("      vs2003    Microsoft Visual Studio 2003");
 	puts("      vs2005    Microsoft Visual Studio 2005 (includes Express editions)");
+	puts("      Separate several names with commas, as in gnu,vs2005");
 	puts("");
 	puts(" --help            Display this information");
 	puts(" --version         Display version information");
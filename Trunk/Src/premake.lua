@@ -30,7 +30,9 @@ package.target   = "premake"
 -- Libraries
 
 	if (OS == "linux") then
-		package.links = { "m" }
+		package.links = { "m", "pthread" }
+	elseif (OS == "bsd") then
+		package.links = { "pthread" }
 	end
 
 
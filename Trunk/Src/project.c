@@ -19,15 +19,41 @@
 #include <string.h>
 #include "premake.h"
 #include "os.h"
+#include "hash.h"
+#include "arena.h"
 
 Project* project = NULL;
 
-static Package*    my_pkg  = NULL;
-static PkgConfig*  my_cfg  = NULL;
-static FileConfig* my_fcfg = NULL;
-static Option*     my_opt  = NULL;
-
-static char buffer[8192];
+/* The selection used by the functions that don't take a context */
+static THREAD_LOCAL PrjCtx my_ctx = { NULL, NULL, 0, NULL, NULL };
+
+static THREAD_LOCAL char buffer[8192];
+
+static const char* buildOutdir(const PrjCtx* ctx, int i, char* buffer);
+static const char* buildPath(const char* from, const char* to, char* buffer);
+static const char* buildTarget(const PrjCtx* ctx, int i, char* buffer);
+
+/* Names of the known build flags, in BuildFlag order */
+static const char* FLAG_NAMES[NUM_BUILD_FLAGS] =
+{
+	"dylib",
+	"extra-warnings",
+	"fatal-warnings",
+	"managed",
+	"no-64bit-checks",
+	"no-exceptions",
+	"no-frame-pointer",
+	"no-import-lib",
+	"no-main",
+	"no-rtti",
+	"no-symbols",
+	"optimize",
+	"optimize-size",
+	"optimize-speed",
+	"static-runtime",
+	"unicode",
+	"unsafe"
+};
 
 
 /************************************************************************
@@ -39,12 +65,14 @@ void   prj_open()
 	if (project != NULL)
 		prj_close();
 	project = ALLOCT(Project);
+	memset(project, 0, sizeof(Project));
+	project->arena = arena_create();
 }
 
 
 void   prj_close()
 {
-	int i, j;
+	int i, j, k;
 
 	if (project != NULL)
 	{
@@ -52,47 +80,71 @@ void   prj_close()
 		{
 			Package* package = project->packages[i];
 
+			/* Configurations with the same files share one index */
 			for (j = 0; j < prj_get_numconfigs(); ++j)
 			{
-				PkgConfig* config = package->configs[j];
-				free((void*)config->buildopts);
-				free((void*)config->defines);
-				free((void*)config->files);
-				free((void*)config->flags);
-				free((void*)config->incpaths);
-				free((void*)config->libpaths);
-				free((void*)config->linkopts);
-				free((void*)config->links);
-				prj_freelist((void**)config->fileconfigs);
+				Hash* index = package->configs[j]->fileIndex;
+				for (k = 0; k < j && package->configs[k]->fileIndex != index; ++k);
+				if (k == j)
+					hash_destroy(index);
 			}
 
-			prj_freelist((void**)package->configs);
 			if (package->data != NULL)
 				free(package->data);
 		}
 
-		prj_freelist((void**)project->options);
-		prj_freelist((void**)project->configs);
-		prj_freelist((void**)project->packages);
+		hash_destroy(project->packageIndex);
+		arena_destroy(project->arena);
 		free(project);
 		project = NULL;
 	}
 }
 
 
+/************************************************************************
+ * Allocate memory for the project model. It is released, along with
+ * everything else in the model, by prj_close().
+ ***********************************************************************/
+
+void* prj_alloc(int size)
+{
+	return arena_alloc(project->arena, size);
+}
+
+
 /************************************************************************
  * Locate a package by name
  ***********************************************************************/
 
 int prj_find_package(const char* name)
+{
+	Package* package;
+
+	if (name == NULL || project->packageIndex == NULL)
+		return -1;
+
+	package = (Package*)hash_find(project->packageIndex, name);
+	return (package != NULL) ? package->index : -1;
+}
+
+
+/************************************************************************
+ * Build the name index used by prj_find_package(). If two packages
+ * have the same name, the first one is found.
+ ***********************************************************************/
+
+void prj_index_packages()
 {
 	int i;
-	for (i = 0; i < prj_get_numpackages(); ++i)
+
+	hash_destroy(project->packageIndex);
+	project->packageIndex = hash_create();
+	for (i = 0; project->packages[i] != NULL; ++i)
 	{
-		if (matches(name, project->packages[i]->name))
-			return i;
+		Package* package = project->packages[i];
+		if (package->name != NULL && hash_find(project->packageIndex, package->name) == NULL)
+			hash_insert(project->packageIndex, package->name, package);
 	}
-	return -1;
 }
 
 
@@ -102,13 +154,12 @@ int prj_find_package(const char* name)
 
 PkgConfig* prj_get_config_for(int i)
 {
-	int j;
-	for (j = 0; j < prj_get_numconfigs(); ++j)
-	{
-		if (my_pkg->configs[j] == my_cfg)
-			return project->packages[i]->configs[j];
-	}
-	return NULL;
+	return prj_ctx_get_config_for(&my_ctx, i);
+}
+
+PkgConfig* prj_ctx_get_config_for(const PrjCtx* ctx, int i)
+{
+	return project->packages[i]->configs[ctx->cfgindex];
 }
 
 
@@ -118,17 +169,17 @@ PkgConfig* prj_get_config_for(int i)
 
 const char* prj_get_buildaction()
 {
-	return my_fcfg->buildaction;
+	return my_ctx.fcfg->buildaction;
 }
 
 int prj_is_buildaction(const char* action)
 {
-	return matches(my_fcfg->buildaction, action);
+	return matches(my_ctx.fcfg->buildaction, action);
 }
 
 void prj_set_buildaction(const char* action)
 {
-	my_fcfg->buildaction = action;
+	my_ctx.fcfg->buildaction = action;
 }
 
 
@@ -138,7 +189,7 @@ void prj_set_buildaction(const char* action)
 
 void* prj_get_data()
 {
-	return prj_get_data_for(my_pkg->index);
+	return prj_get_data_for(my_ctx.pkg->index);
 }
 
 void* prj_get_data_for(int i)
@@ -148,7 +199,7 @@ void* prj_get_data_for(int i)
 
 void prj_set_data(void* data)
 {
-	my_pkg->data = data;
+	my_ctx.pkg->data = data;
 }
 
 
@@ -163,7 +214,7 @@ int prj_get_numdefines()
 
 const char** prj_get_defines()
 {
-	return my_cfg->defines;
+	return my_ctx.cfg->defines;
 }
 
 
@@ -173,66 +224,95 @@ const char** prj_get_defines()
 
 const char* prj_get_bindir()
 {
-	return path_build(my_pkg->path, my_cfg->prjConfig->bindir);
+	return my_ctx.cfg->bindir;
 }
 
 const char* prj_get_bindir_for(int i)
 {
-	Package*   pkg = prj_get_package(i);
-	PkgConfig* cfg = prj_get_config_for(i);
+	return prj_ctx_get_bindir_for(&my_ctx, i, buffer);
+}
 
-	strcpy(buffer, path_build(pkg->path, cfg->prjConfig->bindir));
-	return buffer;
+const char* prj_ctx_get_bindir_for(const PrjCtx* ctx, int i, char* buffer)
+{
+	PkgConfig* cfg = prj_ctx_get_config_for(ctx, i);
+	if (ctx->pkg != project->packages[i])
+		return buildPath(ctx->pkg->path, cfg->prjConfig->bindir, buffer);
+	return cfg->bindir;
 }
 
 const char* prj_get_libdir()
 {
-	return path_build(my_pkg->path, my_cfg->prjConfig->libdir);
+	return my_ctx.cfg->libdir;
 }
 
 const char* prj_get_libdir_for(int i)
 {
-	Package*   pkg = prj_get_package(i);
-	PkgConfig* cfg = prj_get_config_for(i);
+	return prj_ctx_get_libdir_for(&my_ctx, i, buffer);
+}
 
-	strcpy(buffer, path_build(pkg->path, cfg->prjConfig->libdir));
-	return buffer;
+const char* prj_ctx_get_libdir_for(const PrjCtx* ctx, int i, char* buffer)
+{
+	PkgConfig* cfg = prj_ctx_get_config_for(ctx, i);
+	if (ctx->pkg != project->packages[i])
+		return buildPath(ctx->pkg->path, cfg->prjConfig->libdir, buffer);
+	return cfg->libdir;
 }
 
 const char* prj_get_objdir()
 {
-	if (my_cfg->objdir != NULL)
-		return my_cfg->objdir;
-	else
-		return path_combine(my_pkg->objdir, my_cfg->prjConfig->name);
+	return my_ctx.cfg->objpath;
+}
+
+const char* prj_ctx_get_objdir(const PrjCtx* ctx)
+{
+	return ctx->cfg->objpath;
 }
 
 const char* prj_get_pkgobjdir()
 {
-	if (my_cfg->objdir == NULL)
-		return my_pkg->objdir;
+	if (my_ctx.cfg->objdir == NULL)
+		return my_ctx.pkg->objdir;
 	else
 		return NULL;
 }
 
 const char* prj_get_outdir()
 {
-	return prj_get_outdir_for(my_pkg->index);
+	return my_ctx.cfg->outdir;
 }
 
 const char* prj_get_outdir_for(int i)
 {
+	return prj_ctx_get_outdir_for(&my_ctx, i, buffer);
+}
+
+const char* prj_ctx_get_outdir_for(const PrjCtx* ctx, int i, char* buffer)
+{
+	/* Another package's output is reached from the one being written */
+	if (ctx->pkg != project->packages[i])
+		return buildOutdir(ctx, i, buffer);
+	return prj_ctx_get_config_for(ctx, i)->outdir;
+}
+
+static const char* buildOutdir(const PrjCtx* ctx, int i, char* buffer)
+{
+	char dir[8192];
 	const char* targetdir;
 
-	Package*   pkg = prj_get_package_for(i);
-	PkgConfig* cfg = prj_get_config_for(i);
+	const char* base;
+
+	PkgConfig* cfg = prj_ctx_get_config_for(ctx, i);
 	
 	if (matches(cfg->kind, "lib"))
-		strcpy(buffer, prj_get_libdir_for(i));
+		base = prj_ctx_get_libdir_for(ctx, i, buffer);
 	else
-		strcpy(buffer, prj_get_bindir_for(i));
+		base = prj_ctx_get_bindir_for(ctx, i, buffer);
 
-	targetdir = path_getdir(cfg->target);
+	/* A package's own directories are already resolved */
+	if (base != buffer)
+		strcpy(buffer, base);
+
+	targetdir = path_getdir_r(cfg->target, dir);
 	if (strlen(targetdir) > 0)
 	{
 		strcat(buffer, "/");
@@ -249,12 +329,12 @@ const char* prj_get_outdir_for(int i)
 
 const char* prj_get_prefix()
 {
-	return my_cfg->prefix;
+	return my_ctx.cfg->prefix;
 }
 
 const char* prj_get_extension()
 {
-	return my_cfg->extension;
+	return my_ctx.cfg->extension;
 }
 
 
@@ -264,25 +344,65 @@ const char* prj_get_extension()
 
 const char** prj_get_files()
 {
-	return my_cfg->files;
+	return my_ctx.cfg->files;
 }
 
 int prj_has_file(const char* name)
 {
-	const char** ptr = my_cfg->files;
-	while (*ptr != NULL)
+	return prj_ctx_has_file(&my_ctx, name);
+}
+
+int prj_ctx_has_file(const PrjCtx* ctx, const char* name)
+{
+	if (name == NULL)
+		return 0;
+	return (hash_find(ctx->cfg->fileIndex, name) != NULL);
+}
+
+
+/************************************************************************
+ * Returns true if every configuration of the active package builds the
+ * same files, so generators can write the list once
+ ***********************************************************************/
+
+int prj_has_shared_files()
+{
+	return prj_ctx_has_shared_files(&my_ctx);
+}
+
+int prj_ctx_has_shared_files(const PrjCtx* ctx)
+{
+	PkgConfig** configs = ctx->pkg->configs;
+	const char** first = configs[0]->files;
+	int i, j, len;
+
+	len = prj_getlistsize((void**)first);
+	for (i = 1; configs[i] != NULL; ++i)
 	{
-		if (matches(*ptr, name))
-			return 1;
-		ptr++;
+		const char** files = configs[i]->files;
+		if (files == first)
+			continue;
+
+		if (prj_getlistsize((void**)files) != len)
+			return 0;
+		for (j = 0; j < len; ++j)
+		{
+			if (!matches(files[j], first[j]))
+				return 0;
+		}
 	}
 
-	return 0;
+	return 1;
 }
 
 const char* prj_find_filetype(const char* extension)
 {
-	const char** ptr = my_cfg->files;
+	return prj_ctx_find_filetype(&my_ctx, extension);
+}
+
+const char* prj_ctx_find_filetype(const PrjCtx* ctx, const char* extension)
+{
+	const char** ptr = ctx->cfg->files;
 	while (*ptr != NULL)
 	{
 		if (matches(path_getextension(*ptr), extension))
@@ -298,23 +418,37 @@ const char* prj_find_filetype(const char* extension)
  * Query the build flags
  ***********************************************************************/
 
-int prj_has_flag(const char* flag)
+int prj_has_flag(int flag)
 {
-	return prj_has_flag_for(my_pkg->index, flag);
+	return (my_ctx.cfg->flagbits & (1u << flag)) != 0;
 }
 
-int prj_has_flag_for(int i, const char* flag)
+int prj_has_flag_for(int i, int flag)
 {
-	PkgConfig* cfg = prj_get_config_for(i);
-	const char** ptr = cfg->flags;
-	while (*ptr != NULL)
+	return prj_ctx_has_flag_for(&my_ctx, i, flag);
+}
+
+int prj_ctx_has_flag_for(const PrjCtx* ctx, int i, int flag)
+{
+	PkgConfig* cfg = prj_ctx_get_config_for(ctx, i);
+	return (cfg->flagbits & (1u << flag)) != 0;
+}
+
+/* Turn a list of flag names into a set of BuildFlag bits. Names that
+ * aren't known to the generators are left for scripts to look at. */
+unsigned prj_intern_flags(const char** flags)
+{
+	unsigned bits = 0;
+	int i;
+	for (; *flags != NULL; ++flags)
 	{
-		if (matches(*ptr, flag))
-			return 1;
-		ptr++;
+		for (i = 0; i < NUM_BUILD_FLAGS; ++i)
+		{
+			if (matches(*flags, FLAG_NAMES[i]))
+				bits |= (1u << i);
+		}
 	}
-
-	return 0;
+	return bits;
 }
 
 int prj_get_numbuildoptions()
@@ -324,7 +458,7 @@ int prj_get_numbuildoptions()
 
 const char** prj_get_buildoptions()
 {
-	return my_cfg->buildopts;
+	return my_ctx.cfg->buildopts;
 }
 
 int prj_get_numlinkoptions()
@@ -334,7 +468,7 @@ int prj_get_numlinkoptions()
 
 const char** prj_get_linkoptions()
 {
-	return my_cfg->linkopts;
+	return my_ctx.cfg->linkopts;
 }
 
 
@@ -344,12 +478,12 @@ const char** prj_get_linkoptions()
 
 const char* prj_get_kind()
 {
-	return my_cfg->kind;
+	return my_ctx.cfg->kind;
 }
 
 int prj_is_kind(const char* kind)
 {
-	return matches(my_cfg->kind, kind);
+	return matches(my_ctx.cfg->kind, kind);
 }
 
 
@@ -364,7 +498,7 @@ int prj_get_numincpaths()
 
 const char** prj_get_incpaths()
 {
-	return my_cfg->incpaths;
+	return my_ctx.cfg->incpaths;
 }
 
 
@@ -374,7 +508,7 @@ const char** prj_get_incpaths()
 
 const char* prj_get_language()
 {
-	return my_pkg->lang;
+	return my_ctx.pkg->lang;
 }
 
 const char* prj_get_language_for(int i)
@@ -384,7 +518,7 @@ const char* prj_get_language_for(int i)
 
 int prj_is_lang(const char* lang)
 {
-	return matches(my_pkg->lang, lang);
+	return matches(my_ctx.pkg->lang, lang);
 }
 
 
@@ -394,7 +528,7 @@ int prj_is_lang(const char* lang)
 
 const char** prj_get_libpaths()
 {
-	return my_cfg->libpaths;
+	return my_ctx.cfg->libpaths;
 }
 
 
@@ -409,7 +543,7 @@ int prj_get_numlinks()
 
 const char** prj_get_links()
 {
-	return my_cfg->links;
+	return my_ctx.cfg->links;
 }
 
 
@@ -424,12 +558,12 @@ const char* prj_get_name()
 
 const char* prj_get_cfgname()
 {
-	return my_cfg->prjConfig->name;
+	return my_ctx.cfg->prjConfig->name;
 }
 
 const char* prj_get_pkgname()
 {
-	return my_pkg->name;
+	return my_ctx.pkg->name;
 }
 
 const char* prj_get_pkgname_for(int i)
@@ -475,12 +609,12 @@ int prj_get_numpackages()
 
 const char* prj_get_optdesc()
 {
-	return my_opt->desc;
+	return my_ctx.opt->desc;
 }
 
 const char* prj_get_optname()
 {
-	return my_opt->flag;
+	return my_ctx.opt->flag;
 }
 
 
@@ -490,7 +624,7 @@ const char* prj_get_optname()
 
 Package* prj_get_package()
 {
-	return my_pkg;
+	return my_ctx.pkg;
 }
 
 Package* prj_get_package_for(int i)
@@ -510,7 +644,7 @@ const char* prj_get_path()
 
 const char* prj_get_pkgpath()
 {
-	return my_pkg->path;
+	return my_ctx.pkg->path;
 }
 
 const char* prj_get_pkgpath_for(int i)
@@ -520,10 +654,15 @@ const char* prj_get_pkgpath_for(int i)
 
 const char* prj_get_pkgfilename(const char* extension)
 {
-	strcpy(buffer, path_build(project->path, my_pkg->path));
+	return prj_ctx_get_pkgfilename(&my_ctx, extension, buffer);
+}
+
+const char* prj_ctx_get_pkgfilename(const PrjCtx* ctx, const char* extension, char* buffer)
+{
+	path_build_r(project->path, ctx->pkg->path, buffer);
 	if (strlen(buffer) > 0)
 		strcat(buffer, "/");
-	strcat(buffer, my_pkg->name);
+	strcat(buffer, ctx->pkg->name);
 	if (extension != NULL)
 	{
 		strcat(buffer, ".");
@@ -544,7 +683,7 @@ const char* prj_get_script()
 
 const char* prj_get_pkgscript()
 {
-	return my_pkg->script;
+	return my_ctx.pkg->script;
 }
 
 
@@ -554,20 +693,35 @@ const char* prj_get_pkgscript()
 
 const char* prj_get_target()
 {
-	return prj_get_target_for(my_pkg->index);
+	return my_ctx.cfg->targetpath;
 }
 
 const char* prj_get_target_for(int i)
 {
+	return prj_ctx_get_target_for(&my_ctx, i, buffer);
+}
+
+const char* prj_ctx_get_target_for(const PrjCtx* ctx, int i, char* buffer)
+{
+	if (ctx->pkg != project->packages[i])
+		return buildTarget(ctx, i, buffer);
+	return prj_ctx_get_config_for(ctx, i)->targetpath;
+}
+
+static const char* buildTarget(const PrjCtx* ctx, int i, char* buffer)
+{
+	char name[8192];
 	const char* extension = "";
 
-	/* Get the active configuration for this target */
-	Package* pkg = prj_get_package_for(i);
-	PkgConfig* cfg = prj_get_config_for(i);
-	const char* filename = path_getbasename(cfg->target);
+	/* Get the active configuration for this target. The whole name is
+	 * used: a dotted target such as "foo.bar" doesn't have its last part
+	 * taken for an extension */
+	Package* pkg = project->packages[i];
+	PkgConfig* cfg = prj_ctx_get_config_for(ctx, i);
+	const char* filename = path_getname_r(cfg->target, name);
 
 	/* Prepopulate the buffer with the output directory */
-	prj_get_outdir_for(i);
+	buildOutdir(ctx, i, buffer);
 	if (matches(buffer, "."))
 		strcpy(buffer, "");
 	if (strlen(buffer) > 0)
@@ -598,7 +752,7 @@ const char* prj_get_target_for(int i)
 
 	else if (os_is("macosx") && matches(cfg->kind, "dll"))
 	{
-		if (prj_has_flag_for(i, "dylib"))
+		if (prj_ctx_has_flag_for(ctx, i, FLAG_DYLIB))
 		{
 			strcat(buffer, filename);
 			extension = "dylib";
@@ -647,13 +801,72 @@ const char* prj_get_target_for(int i)
 }
 
 
+/************************************************************************
+ * The directories and target of each package configuration depend only
+ * on the model, so they are worked out once after it is exported and
+ * shared by every generator that runs over it. Paths between packages
+ * are built from the working directory of that time, rather than asking
+ * the system for it on every call.
+ ***********************************************************************/
+
+static const char* copyString(const char* str)
+{
+	char* copy = (char*)prj_alloc(strlen(str) + 1);
+	strcpy(copy, str);
+	return copy;
+}
+
+static const char* buildPath(const char* from, const char* to, char* buffer)
+{
+	if (project->cwd == NULL)
+		return path_build_r(from, to, buffer);
+	return path_build_in_r(project->cwd, from, to, buffer);
+}
+
+void prj_resolve_paths()
+{
+	char path[8192];
+	PrjCtx ctx;
+	int i, j;
+
+	project->cwd = copyString(io_getcwd());
+
+	prj_ctx_init(&ctx);
+	for (i = 0; i < prj_get_numpackages(); ++i)
+	{
+		Package* pkg = project->packages[i];
+		for (j = 0; j < prj_get_numconfigs(); ++j)
+		{
+			PkgConfig* cfg = pkg->configs[j];
+			ctx.pkg = pkg;
+			ctx.cfg = cfg;
+			ctx.cfgindex = j;
+
+			/* The output directory and target are built on these two */
+			cfg->bindir = copyString(buildPath(pkg->path, cfg->prjConfig->bindir, path));
+			cfg->libdir = copyString(buildPath(pkg->path, cfg->prjConfig->libdir, path));
+
+			if (cfg->objdir != NULL)
+				cfg->objpath = cfg->objdir;
+			else
+				cfg->objpath = copyString(path_combine_r(pkg->objdir, cfg->prjConfig->name, path));
+
+			cfg->outdir = copyString(buildOutdir(&ctx, i, path));
+			cfg->targetpath = copyString(buildTarget(&ctx, i, path));
+			cfg->targetname = copyString(path_getname_r(cfg->target, path));
+		}
+	}
+}
+
+
 const char* prj_get_targetname_for(int i)
 {
-	Package* pkg = prj_get_package_for(i);
-	PkgConfig* cfg = prj_get_config_for(i);
+	return prj_ctx_get_targetname_for(&my_ctx, i);
+}
 
-	strcpy(buffer, path_getname(cfg->target));
-	return buffer;
+const char* prj_ctx_get_targetname_for(const PrjCtx* ctx, int i)
+{
+	return prj_ctx_get_config_for(ctx, i)->targetname;
 }
 
 
@@ -663,7 +876,7 @@ const char* prj_get_targetname_for(int i)
 
 const char* prj_get_url()
 {
-	return my_pkg->url;
+	return my_ctx.pkg->url;
 }
 
 
@@ -673,29 +886,71 @@ const char* prj_get_url()
 
 void prj_select_config(int i)
 {
-	if (my_pkg == NULL)
-		prj_select_package(0);
-	my_cfg = my_pkg->configs[i];
+	prj_ctx_select_config(&my_ctx, i);
 }
 
 void prj_select_file(const char* name)
 {
-	int i;
-	for (i = 0; i < prj_getlistsize((void**)my_cfg->files); ++i)
-	{
-		if (matches(my_cfg->files[i], name))
-			my_fcfg = my_cfg->fileconfigs[i];
-	}
+	prj_ctx_select_file(&my_ctx, name);
 }
 
-void prj_select_option(i)
+void prj_select_option(int i)
 {
-	my_opt = project->options[i];
+	prj_ctx_select_option(&my_ctx, i);
 }
 
 void prj_select_package(int i)
 {
-	my_pkg = project->packages[i];
+	prj_ctx_select_package(&my_ctx, i);
+}
+
+
+/************************************************************************
+ * Contexts. A context holds its own selection, so that more than one
+ * package or configuration can be worked on at the same time. The
+ * prj_ctx_ functions that build a string write it into a caller-owned
+ * buffer of at least 8192 bytes.
+ ***********************************************************************/
+
+void prj_ctx_init(PrjCtx* ctx)
+{
+	ctx->pkg = NULL;
+	ctx->cfg = NULL;
+	ctx->cfgindex = 0;
+	ctx->fcfg = NULL;
+	ctx->opt = NULL;
+}
+
+void prj_ctx_select_config(PrjCtx* ctx, int i)
+{
+	if (ctx->pkg == NULL)
+		prj_ctx_select_package(ctx, 0);
+	ctx->cfg = ctx->pkg->configs[i];
+	ctx->cfgindex = i;
+}
+
+void prj_ctx_select_file(PrjCtx* ctx, const char* name)
+{
+	FileConfig* fconfig;
+	if (name == NULL)
+		return;
+
+	fconfig = (FileConfig*)hash_find(ctx->cfg->fileIndex, name);
+	if (fconfig != NULL)
+		ctx->fcfg = fconfig;
+}
+
+void prj_ctx_select_option(PrjCtx* ctx, int i)
+{
+	ctx->opt = project->options[i];
+}
+
+/* The selected configuration follows the package */
+void prj_ctx_select_package(PrjCtx* ctx, int i)
+{
+	ctx->pkg = project->packages[i];
+	if (ctx->cfg != NULL)
+		ctx->cfg = ctx->pkg->configs[ctx->cfgindex];
 }
 
 
@@ -703,31 +958,31 @@ void prj_select_package(int i)
  * List management routines
  ***********************************************************************/
 
+/* Lists are NULL-terminated arrays, so that generators can walk them
+ * directly, with the item count kept in a header just before the first
+ * item. Counting a list does not have to walk it. Like the rest of the
+ * model they are allocated from the project arena. */
+
 void** prj_newlist(int len)
 {
-	void** list = (void**)malloc(sizeof(void*) * (len + 1));
+	char*  block = (char*)prj_alloc(PRJ_LIST_HEADER + sizeof(void*) * (len + 1));
+	void** list  = (void**)(block + PRJ_LIST_HEADER);
+	*(int*)block = len;
 	list[len] = NULL;
 	return list;
 }
 
 
-void prj_freelist(void** list)
+int prj_getlistsize(void** list)
 {
-	int i = 0;
-	while (list[i] != NULL)
-		free(list[i++]);
-	free(list);
+	return *(int*)((char*)list - PRJ_LIST_HEADER);
 }
 
 
-int prj_getlistsize(void** list)
+/* Shorten a list once it has been filled, when fewer items were used
+ * than were allocated */
+void prj_truncatelist(void** list, int len)
 {
-	int count = 0;
-	void** ptr = list;
-	while (*ptr != NULL)
-	{
-		ptr++;
-		count++;
-	}
-	return count;
+	list[len] = NULL;
+	*(int*)((char*)list - PRJ_LIST_HEADER) = len;
 }
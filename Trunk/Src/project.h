@@ -15,6 +15,29 @@
  * GNU General Public License in the file LICENSE.txt for details.
  **********************************************************************/
 
+/* Build flags known to the generators; any others stay in the list */
+enum BuildFlag
+{
+	FLAG_DYLIB,
+	FLAG_EXTRA_WARNINGS,
+	FLAG_FATAL_WARNINGS,
+	FLAG_MANAGED,
+	FLAG_NO_64BIT_CHECKS,
+	FLAG_NO_EXCEPTIONS,
+	FLAG_NO_FRAME_POINTER,
+	FLAG_NO_IMPORT_LIB,
+	FLAG_NO_MAIN,
+	FLAG_NO_RTTI,
+	FLAG_NO_SYMBOLS,
+	FLAG_OPTIMIZE,
+	FLAG_OPTIMIZE_SIZE,
+	FLAG_OPTIMIZE_SPEED,
+	FLAG_STATIC_RUNTIME,
+	FLAG_UNICODE,
+	FLAG_UNSAFE,
+	NUM_BUILD_FLAGS
+};
+
 typedef struct tagOption
 {
 	const char* flag;
@@ -42,6 +65,7 @@ typedef struct tagPkgConfig
 	const char*  extension;
 	const char** files;
 	const char** flags;
+	unsigned     flagbits;
 	const char** incpaths;
 	const char** libpaths;
 	const char** linkopts;
@@ -51,6 +75,16 @@ typedef struct tagPkgConfig
 	const char*  target;
 	const char*  kind;
 	FileConfig** fileconfigs;
+	struct tagHash* fileIndex;
+
+	/* Worked out from the rest by prj_resolve_paths(); directories are
+	 * relative to the package's own path */
+	const char*  bindir;
+	const char*  libdir;
+	const char*  objpath;
+	const char*  outdir;
+	const char*  targetpath;
+	const char*  targetname;
 } PkgConfig;
 
 typedef struct tagPackage
@@ -75,16 +109,37 @@ typedef struct tagProject
 	Option**    options;
 	PrjConfig** configs;
 	Package**   packages;
+	struct tagHash* packageIndex;
+	struct tagArena* arena;
+	const char* cwd;             /* where prj_resolve_paths() ran */
 } Project;
 
 extern Project* project;
 
+/* A selection of project objects, for the prj_ctx_ functions */
+typedef struct tagPrjCtx
+{
+	Package*    pkg;
+	PkgConfig*  cfg;
+	int         cfgindex;
+	FileConfig* fcfg;
+	Option*     opt;
+} PrjCtx;
+
+/* The project model lives in an arena, released as a whole by prj_close() */
+#define PRJ_ALLOCT(T)  (T*)prj_alloc(sizeof(T))
+
+/* Space before the first item of a list, where its length is kept */
+#define PRJ_LIST_HEADER  sizeof(void*)
+
 
 void         prj_open();
 void         prj_close();
+void*        prj_alloc(int size);
 
 const char*  prj_find_filetype(const char* extension);
 int          prj_find_package(const char* name);
+void         prj_index_packages();
 const char*  prj_get_bindir();
 const char*  prj_get_buildaction();
 const char** prj_get_buildoptions();
@@ -135,11 +190,13 @@ const char*  prj_get_target_for(int i);
 const char*  prj_get_targetname_for(int i);
 const char*  prj_get_url();
 int          prj_has_file(const char* name);
-int          prj_has_flag(const char* flag);
-int          prj_has_flag_for(int i, const char* flag);
+int          prj_has_flag(int flag);
+int          prj_has_flag_for(int i, int flag);
+int          prj_has_shared_files();
 int          prj_is_buildaction(const char* action);
 int          prj_is_kind(const char* kind);
 int          prj_is_lang(const char* lang);
+void         prj_resolve_paths();
 void         prj_select_config(int i);
 void         prj_select_file(const char* name);
 void         prj_select_option(int i);
@@ -147,7 +204,26 @@ void         prj_select_package(int i);
 void         prj_set_buildaction(const char* action);
 void         prj_set_data(void* data);
 
+void         prj_ctx_init(PrjCtx* ctx);
+const char*  prj_ctx_find_filetype(const PrjCtx* ctx, const char* extension);
+const char*  prj_ctx_get_bindir_for(const PrjCtx* ctx, int i, char* buffer);
+PkgConfig*   prj_ctx_get_config_for(const PrjCtx* ctx, int i);
+const char*  prj_ctx_get_libdir_for(const PrjCtx* ctx, int i, char* buffer);
+const char*  prj_ctx_get_objdir(const PrjCtx* ctx);
+const char*  prj_ctx_get_outdir_for(const PrjCtx* ctx, int i, char* buffer);
+const char*  prj_ctx_get_pkgfilename(const PrjCtx* ctx, const char* extension, char* buffer);
+const char*  prj_ctx_get_target_for(const PrjCtx* ctx, int i, char* buffer);
+const char*  prj_ctx_get_targetname_for(const PrjCtx* ctx, int i);
+int          prj_ctx_has_file(const PrjCtx* ctx, const char* name);
+int          prj_ctx_has_flag_for(const PrjCtx* ctx, int i, int flag);
+int          prj_ctx_has_shared_files(const PrjCtx* ctx);
+void         prj_ctx_select_config(PrjCtx* ctx, int i);
+void         prj_ctx_select_file(PrjCtx* ctx, const char* name);
+void         prj_ctx_select_option(PrjCtx* ctx, int i);
+void         prj_ctx_select_package(PrjCtx* ctx, int i);
+
+unsigned     prj_intern_flags(const char** flags);
 void**       prj_newlist(int len);
-void         prj_freelist(void** list);
 int          prj_getlistsize(void** list);
+void         prj_truncatelist(void** list, int len);
 
@@ -21,6 +21,8 @@
 #include "script.h"
 #include "arg.h"
 #include "os.h"
+#include "hash.h"
+#include "match.h"
 #include "Lua/lua.h"
 #include "Lua/lualib.h"
 #include "Lua/lauxlib.h"
@@ -28,12 +30,19 @@
 
 static lua_State*  L;
 static const char* currentScript = NULL;
+static char**      loadedScripts = NULL;
+static int         numLoadedScripts = 0;
+
+/* The model is only exported again when the script state may have changed */
+static int         generation = 0;
+static int         exported = -1;
 
 
 static int         tbl_get(int from, const char* name);
 static int         tbl_geti(int from, int i);
 static int         tbl_getlen(int tbl);
 static int         tbl_getlen_deep(int tbl);
+static int         tbl_getstrings(int tbl, const char** list, int pos);
 static const char* tbl_getstring(int from, const char* name);
 static const char* tbl_getstringi(int from, int i);
 
@@ -63,6 +72,7 @@ static int         lf_setconfigs(lua_State* L);
 
 static void        buildOptionsTable();
 static void        buildNewProject();
+static void        addLoadedScript(const char* filename);
 
 
 /**********************************************************************
@@ -223,7 +233,13 @@ int script_run(const char* filename)
 		return 0;
 	}
 
+	/* Start a new list of the script files that make up the project */
+	while (numLoadedScripts > 0)
+		free(loadedScripts[--numLoadedScripts]);
+	addLoadedScript(scriptname);
+
 	currentScript = scriptname;
+	generation++;
 	if (!script_init())
 		return -1;
 
@@ -237,22 +253,32 @@ int script_run(const char* filename)
  * out into local objects
  **********************************************************************/
 
-static int export_list(int parent, int object, const char* name, const char*** list)
+/* A list set on the package is exported once. Each configuration that
+ * adds nothing to it shares the package's copy, and the others start
+ * their own from it, so nothing is taken from Lua more than once. */
+static const char** export_shared(int parent, const char* name)
 {
-	int i;
+	int arr = tbl_get(parent, name);
+	const char** list = (const char**)prj_newlist(tbl_getlen_deep(arr));
+	tbl_getstrings(arr, list, 0);
+	return list;
+}
 
-	int parArr = tbl_get(parent, name);
-	int parLen = tbl_getlen_deep(parArr);
+static int export_list(int object, const char* name, const char** shared, const char*** list)
+{
+	int parLen = prj_getlistsize((void**)shared);
 	int objArr = tbl_get(object, name);
 	int objLen = tbl_getlen_deep(objArr);
 
-	*list = (const char**)prj_newlist(parLen + objLen);
-
-	for (i = 0; i < parLen; ++i)
-		(*list)[i] = tbl_getstringi(parArr, i + 1);
+	if (objLen == 0)
+	{
+		*list = shared;
+		return parLen;
+	}
 
-	for (i = 0; i < objLen; ++i)
-		(*list)[parLen + i] = tbl_getstringi(objArr, i + 1);
+	*list = (const char**)prj_newlist(parLen + objLen);
+	memcpy((void*)*list, shared, sizeof(const char*) * parLen);
+	tbl_getstrings(objArr, *list, parLen);
 
 	return (parLen + objLen);
 }
@@ -266,41 +292,46 @@ static const char* export_value(int parent, int object, const char* name)
 	return value;
 }
 
-static const char** export_files(int tbl, int obj)
+/* Files may be listed more than once, when masks overlap or a matched
+ * file is also named explicitly. Only the first mention is kept, so the
+ * order of the list is otherwise left as the script wrote it. */
+static const char** export_files(int obj, const char** pkgFiles, const char** pkgExcludes)
 {
 	const char** files;
 	const char** excludes;
-	const char** result;
+	Hash* seen;
 	int numFiles, numExcludes;
-	int i, j, k;
+	int i, k;
 
-	export_list(tbl, obj, "files", &files);
-	export_list(tbl, obj, "excludes", &excludes);
+	numFiles = export_list(obj, "files", pkgFiles, &files);
+	numExcludes = export_list(obj, "excludes", pkgExcludes, &excludes);
 
-	numFiles = prj_getlistsize((void**)files);
-	numExcludes = prj_getlistsize((void**)excludes);
+	/* The package's own list is left alone for the next configuration */
+	if (files == pkgFiles)
+	{
+		files = (const char**)prj_newlist(numFiles);
+		memcpy((void*)files, pkgFiles, sizeof(const char*) * numFiles);
+	}
 
-	result = (const char**)prj_newlist(numFiles);
+	/* Excluded files are treated as if they had been seen already */
+	seen = hash_create();
+	for (i = 0; i < numExcludes; ++i)
+	{
+		if (excludes[i] != NULL)
+			hash_insert(seen, excludes[i], (void*)excludes[i]);
+	}
 
+	/* The list is compacted in place, since arena memory is not given back */
 	k = 0;
 	for (i = 0; i < numFiles; ++i)
 	{
-		int exclude = 0;
-		for (j = 0; j < numExcludes; ++j)
-		{
-			if (matches(files[i], excludes[j]))
-				exclude = 1;
-		}
-
-		if (!exclude)
-			result[k++] = files[i];
+		if (files[i] != NULL && hash_insert(seen, files[i], (void*)files[i]))
+			files[k++] = files[i];
 	}
 
-	free((void*)files);
-	free((void*)excludes);
-
-	result[k] = NULL;
-	return result;
+	hash_destroy(seen);
+	prj_truncatelist((void**)files, k);
+	return files;
 }
 
 static int export_fileconfig(PkgConfig* config, int arr)
@@ -309,11 +340,15 @@ static int export_fileconfig(PkgConfig* config, int arr)
 
 	count = prj_getlistsize((void**)config->files);
 	config->fileconfigs = (FileConfig**)prj_newlist(count);
+	config->fileIndex = hash_create();
 	for (i = 0; i < count; ++i)
 	{
-		FileConfig* fconfig = ALLOCT(FileConfig);
+		FileConfig* fconfig = PRJ_ALLOCT(FileConfig);
 		config->fileconfigs[i] = fconfig;
 
+		/* Per-file queries come in by name; a later duplicate wins */
+		hash_insert(config->fileIndex, config->files[i], fconfig);
+
 		obj = tbl_get(arr, config->files[i]);
 		if (obj > 0)
 		{
@@ -330,7 +365,17 @@ static int export_fileconfig(PkgConfig* config, int arr)
 
 static int export_pkgconfig(Package* package, int tbl)
 {
-	int arr, obj;
+	const char** flags    = export_shared(tbl, "buildflags");
+	const char** opts     = export_shared(tbl, "buildoptions");
+	const char** defines  = export_shared(tbl, "defines");
+	const char** incpaths = export_shared(tbl, "includepaths");
+	const char** libpaths = export_shared(tbl, "libpaths");
+	const char** linkopts = export_shared(tbl, "linkoptions");
+	const char** links    = export_shared(tbl, "links");
+	const char** files    = export_shared(tbl, "files");
+	const char** excludes = export_shared(tbl, "excludes");
+	PkgConfig* plain = NULL;
+	int arr, obj, inherits;
 	int len, i;
 
 	arr = tbl_get(tbl, "config");
@@ -338,7 +383,7 @@ static int export_pkgconfig(Package* package, int tbl)
 	package->configs = (PkgConfig**)prj_newlist(len);
 	for (i = 0; i < len; ++i)
 	{
-		PkgConfig* config = ALLOCT(PkgConfig);
+		PkgConfig* config = PRJ_ALLOCT(PkgConfig);
 		package->configs[i] = config;
 		config->prjConfig = project->configs[i];
 
@@ -355,19 +400,32 @@ static int export_pkgconfig(Package* package, int tbl)
 			config->target = package->name;
 
 		/* Pull out the value lists */
-		export_list(tbl, obj, "buildflags",   &config->flags);
-		export_list(tbl, obj, "buildoptions", &config->buildopts);
-		export_list(tbl, obj, "defines",      &config->defines);
-		export_list(tbl, obj, "includepaths", &config->incpaths);
-		export_list(tbl, obj, "libpaths",     &config->libpaths);
-		export_list(tbl, obj, "linkoptions",  &config->linkopts);
-		export_list(tbl, obj, "links",        &config->links);
-
-		/* Build the file list */
-		config->files = export_files(tbl, obj);
-
-		/* Build a list of file configurations */
+		export_list(obj, "buildflags",   flags,    &config->flags);
+		export_list(obj, "buildoptions", opts,     &config->buildopts);
+		export_list(obj, "defines",      defines,  &config->defines);
+		export_list(obj, "includepaths", incpaths, &config->incpaths);
+		export_list(obj, "libpaths",     libpaths, &config->libpaths);
+		export_list(obj, "linkoptions",  linkopts, &config->linkopts);
+		export_list(obj, "links",        links,    &config->links);
+		config->flagbits = prj_intern_flags(config->flags);
+
+		/* Configurations that don't add or exclude files of their own
+		 * share one file list, and the file configurations that go with
+		 * it, since those are set on the package */
+		inherits = (tbl_getlen_deep(tbl_get(obj, "files")) == 0 &&
+		            tbl_getlen_deep(tbl_get(obj, "excludes")) == 0);
+		if (inherits && plain != NULL)
+		{
+			config->files       = plain->files;
+			config->fileconfigs = plain->fileconfigs;
+			config->fileIndex   = plain->fileIndex;
+			continue;
+		}
+
+		config->files = export_files(obj, files, excludes);
 		export_fileconfig(config, arr);
+		if (inherits)
+			plain = config;
 	}
 
 	return 1;
@@ -379,6 +437,10 @@ int script_export()
 	int tbl, arr, obj;
 	int len, i;
 
+	if (project != NULL && exported == generation)
+		return 1;
+	exported = generation;
+
 	prj_open();
 
 	/* Copy out the list of available options */
@@ -387,7 +449,7 @@ int script_export()
 	project->options = (Option**)prj_newlist(len);
 	for (i = 0; i < len; ++i)
 	{
-		Option* option = ALLOCT(Option);
+		Option* option = PRJ_ALLOCT(Option);
 		project->options[i] = option;
 
 		obj = tbl_geti(tbl, i + 1);
@@ -407,7 +469,7 @@ int script_export()
 	project->configs = (PrjConfig**)prj_newlist(len);
 	for (i = 0; i < len; ++i)
 	{
-		PrjConfig* config = ALLOCT(PrjConfig);
+		PrjConfig* config = PRJ_ALLOCT(PrjConfig);
 		project->configs[i] = config;
 
 		obj = tbl_geti(arr, i + 1);
@@ -422,7 +484,7 @@ int script_export()
 	project->packages = (Package**)prj_newlist(len);
 	for (i = 0; i < len; ++i)
 	{
-		Package* package = ALLOCT(Package);
+		Package* package = PRJ_ALLOCT(Package);
 		package->index = i;
 		project->packages[i] = package;
 		
@@ -439,6 +501,9 @@ int script_export()
 		export_pkgconfig(package, obj);
 	}
 
+	/* Links to sibling packages are looked up by name */
+	prj_index_packages();
+	prj_resolve_paths();
 	return 1;
 }
 
@@ -479,6 +544,10 @@ int script_docommand(const char* cmd)
 	else
 		lua_pushnil(L);
 
+	/* A handler written in Lua may change the project settings */
+	if (!lua_iscfunction(L, -3))
+		generation++;
+
 	lua_call(L, 2, 0);
 	return 1;
 }
@@ -491,6 +560,27 @@ int script_close()
 }
 
 
+/**********************************************************************
+ * Retrieve the full path to each of the script files run so far,
+ * returning NULL past the end of the list
+ **********************************************************************/
+
+const char* script_getloaded(int i)
+{
+	return (i < numLoadedScripts) ? loadedScripts[i] : NULL;
+}
+
+
+static void addLoadedScript(const char* filename)
+{
+	const char* path = path_absolute(filename);
+	loadedScripts = (char**)realloc(loadedScripts, sizeof(char*) * (numLoadedScripts + 1));
+	loadedScripts[numLoadedScripts] = (char*)malloc(strlen(path) + 1);
+	strcpy(loadedScripts[numLoadedScripts], path);
+	numLoadedScripts++;
+}
+
+
 
 /**********************************************************************
  * These function assist with setup of the script environment
@@ -747,26 +837,31 @@ static int tbl_getlen(int tbl)
 }
 
 
-static int tbl_getlen_deep(int tbl)
+static int tbl_getlen_deep_worker(int index)
 {
-	int size, i;
-	lua_getref(L, tbl);
+	int size, len, i;
 
 	size = 0;
-	for (i = 1; i <= luaL_getn(L, -1); ++i)
+	len = luaL_getn(L, index);
+	for (i = 1; i <= len; ++i)
 	{
-		lua_rawgeti(L, -1, i);
+		lua_rawgeti(L, index, i);
 		if (lua_istable(L, -1))
-		{
-			size += tbl_getlen_deep(lua_ref(L, -1));
-		}
+			size += tbl_getlen_deep_worker(lua_gettop(L));
 		else
-		{
-			lua_pop(L, 1);
 			size++;
-		}
+		lua_pop(L, 1);
 	}
 
+	return size;
+}
+
+static int tbl_getlen_deep(int tbl)
+{
+	int size = 0;
+	lua_getref(L, tbl);
+	if (lua_istable(L, -1))
+		size = tbl_getlen_deep_worker(lua_gettop(L));
 	lua_pop(L, 1);
 	return size;
 }
@@ -817,6 +912,35 @@ static const char* tbl_getstringi_worker(int arr, int* index)
 	return result;
 }
 
+/* Flatten a table of strings (and nested tables of strings) into a
+ * list, starting at pos. Returns the position after the last string. */
+static int tbl_getstrings_worker(int index, const char** list, int pos)
+{
+	int len, i;
+
+	len = luaL_getn(L, index);
+	for (i = 1; i <= len; ++i)
+	{
+		lua_rawgeti(L, index, i);
+		if (lua_istable(L, -1))
+			pos = tbl_getstrings_worker(lua_gettop(L), list, pos);
+		else
+			list[pos++] = lua_tostring(L, -1);
+		lua_pop(L, 1);
+	}
+
+	return pos;
+}
+
+static int tbl_getstrings(int tbl, const char** list, int pos)
+{
+	lua_getref(L, tbl);
+	if (lua_istable(L, -1))
+		pos = tbl_getstrings_worker(lua_gettop(L), list, pos);
+	lua_pop(L, 1);
+	return pos;
+}
+
 static const char* tbl_getstringi(int from, int i)
 {
 	int index = i;
@@ -904,6 +1028,9 @@ static int lf_docommand(lua_State* L)
 	const char* arg = (!lua_isnil(L,2)) ? luaL_checkstring(L, 2) : NULL;
 	if (!onCommand(cmd, arg))
 		exit(1);
+
+	/* The generators fill in defaults on the model as they go */
+	generation++;
 	return 0;
 }
 
@@ -966,6 +1093,7 @@ static int lf_dopackage(lua_State* L)
 		lua_error(L);
 	}
 
+	addLoadedScript(filename);
 	currentScript = filename;
 	io_chdir(path_getdir(filename));
 
@@ -1058,62 +1186,21 @@ static int lf_getname(lua_State* L)
 }
 
 
-static int debugging = 0;
+static int numMatches;
 
-static void doFileScan(lua_State* L, char* path, int recursive)
+static void addMatch(const char* name)
 {
-	MaskHandle handle;
-
-	if (debugging) puts(path);
-	
-	handle = io_mask_open(path);
-	while (io_mask_getnext(handle))
-	{
-		if (io_mask_isfile(handle))
-		{
-			const char* name = io_mask_getname(handle);
-			lua_pushstring(L, name);
-			lua_rawseti(L, -2, luaL_getn(L, -2) + 1);
-		}
-	}
-	io_mask_close(handle);
-
-	/* If recursive, scan subdirectories */
-	if (recursive)
-	{
-		char mask[128];
-		int len;
-		
-		/* Split the mask from the path */
-		strcpy(mask, path_getname(path));
-		strcpy(path, path_getdir(path));
-		
-		/* Scan for subdirs */
-		len = strlen(path);
-		handle = io_mask_open(path_combine(path, "*"));
-		while (io_mask_getnext(handle))
-		{
-			if (!io_mask_isfile(handle))
-			{
-				const char* name = io_mask_getname(handle);
-				if (!matches(name, ".") && !matches(name, "..") && !endsWith(name, "/.") && !endsWith(name, "/.."))
-				{
-					strcpy(path, path_combine(name, mask));
-					doFileScan(L, path, recursive);
-					path[len] = '\0';
-				}
-			}
-		}
-		io_mask_close(handle);
-	}
+	lua_pushstring(L, name);
+	lua_rawseti(L, -2, ++numMatches);
 }
 
 static int doFileMatching(lua_State* L, int recursive)
 {
 	char path[8192];
+	const char** masks;
 	const char* pkgPath;
 	const char* filename;
-	int pathlen, i;
+	int numMasks, pathlen, i;
 
 	/* Get the current package path */
 	lua_getglobal(L, "package");
@@ -1126,22 +1213,44 @@ static int doFileMatching(lua_State* L, int recursive)
 	if (path_compare(path_getdir(currentScript), pkgPath))
 		pkgPath = "";
 
+	/* Build the list of patterns. A recursive search is the same as
+	 * putting a "**" between the directory and the file name. Masks
+	 * starting with "!" exclude files instead, and keep the "!". */
+	numMasks = lua_gettop(L);
+	masks = (const char**)malloc(sizeof(char*) * numMasks);
+	for (i = 0; i < numMasks; ++i)
+	{
+		const char* mask = luaL_checkstring(L, i + 1);
+		int exclude = (mask[0] == '!');
+		strcpy(path, exclude ? "!" : "");
+		strcat(path, path_combine(pkgPath, mask + exclude));
+		if (recursive && strstr(path, "**") == NULL)
+		{
+			char* ptr = strrchr(path, '/');
+			ptr = (ptr != NULL) ? ptr + 1 : path + exclude;
+			memmove(ptr + 3, ptr, strlen(ptr) + 1);
+			memcpy(ptr, "**/", 3);
+		}
+
+		masks[i] = (char*)malloc(strlen(path) + 1);
+		strcpy((char*)masks[i], path);
+	}
+
 	/* Create a table to hold the results */
 	lua_newtable(L);
 
-	/* Scan each mask */
-	for (i = 1; i < lua_gettop(L); ++i)
-	{
-		const char* mask = luaL_checkstring(L, i);
-		const char* maskWithPath = path_combine(pkgPath, mask);
-		strcpy(path, maskWithPath);
-		doFileScan(L, path, recursive);
-	}
+	/* Scan for all of the masks in a single pass */
+	numMatches = 0;
+	match_scan(masks, numMasks, addMatch);
+
+	for (i = 0; i < numMasks; ++i)
+		free((void*)masks[i]);
+	free((void*)masks);
 
 	/* Remove the base package path from all files */
 	pathlen = strlen(pkgPath);
 	if (pathlen > 0) pathlen++;
-	for (i = 1; i <= luaL_getn(L, -1); ++i)
+	for (i = 1; i <= numMatches; ++i)
 	{
 		lua_rawgeti(L, -1, i);
 		filename = lua_tostring(L, -1);
@@ -1150,7 +1259,6 @@ static int doFileMatching(lua_State* L, int recursive)
 		lua_pop(L, 1);
 	}
 
-	debugging = 0;
 	return 1;
 }
 
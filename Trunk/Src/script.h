@@ -19,3 +19,4 @@ int script_run(const char* filename);
 int script_export();
 int script_docommand();
 int script_close();
+const char* script_getloaded(int i);
@@ -16,50 +16,49 @@
  **********************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "premake.h"
 #include "sharpdev.h"
+#include "state.h"
+#include "os.h"
 
 int sharpdev_target;
-int sharpdev_warncontent;
+const char* sharpdev_dotnet;
+THREAD_LOCAL int sharpdev_warncontent;
 
+/* Which packages used the 'Content' build action */
+static char* my_warned;
+
+static int writePackage(int i);
 static int writeCombine();
 
 int sharpdev_generate(const char* targetName)
 {
-	int i;
+	int warncontent, result, i;
 
 	sharpdev_target = matches(targetName, "monodev") ? MONODEV : SHARPDEV;
-	sharpdev_warncontent = 0;
 
 	printf("Generating %sDevelop combine and project files:\n", (sharpdev_target == SHARPDEV) ? "Sharp" : "Mono");
 
-	if (!writeCombine())
-		return 0;
+	/* Figure out what .NET environment I'm using; the default is kept
+	 * out of g_dotnet, which other targets in this run still look at */
+	sharpdev_dotnet = g_dotnet;
+	if (sharpdev_dotnet == NULL)
+		sharpdev_dotnet = (os_is("windows") || sharpdev_target == MONODEV) ? "ms" : "mono";
 
+	my_warned = (char*)calloc(prj_get_numpackages() + 1, 1);
+	result = state_run(prj_get_numpackages(), writePackage);
+
+	warncontent = 0;
 	for (i = 0; i < prj_get_numpackages(); ++i)
-	{
-		prj_select_package(i);
+		warncontent |= my_warned[i];
+	free(my_warned);
 
-		printf("...%s\n", prj_get_pkgname());
-		if (prj_is_lang("c#"))
-		{
-			if (!sharpdev_cs())
-				return 0;
-		}
-		else if (prj_is_lang("c++") || prj_is_lang("c"))
-		{
-			printf("** Error: this generator does not support C/C++ development.\n");
-			return 0;
-		}
-		else
-		{
-			printf("** Error: unrecognized language '%s'\n", prj_get_language());
-			return 0;
-		}
-	}
+	if (!result || !writeCombine())
+		return 0;
 
-	if (sharpdev_warncontent)
+	if (warncontent)
 	{
 		puts("\n** Warning: this project uses the 'Content' build action. This action is not");
 		puts("            supported by #develop; some manual configuration may be needed.");
@@ -69,6 +68,34 @@ int sharpdev_generate(const char* targetName)
 }
 
 
+static int writePackage(int i)
+{
+	int result;
+
+	prj_select_package(i);
+	prj_select_config(0);
+
+	printf("...%s\n", prj_get_pkgname());
+	if (prj_is_lang("c#"))
+	{
+		sharpdev_warncontent = 0;
+		result = sharpdev_cs();
+		my_warned[i] = (char)sharpdev_warncontent;
+		return result;
+	}
+	else if (prj_is_lang("c++") || prj_is_lang("c"))
+	{
+		printf("** Error: this generator does not support C/C++ development.\n");
+		return 0;
+	}
+	else
+	{
+		printf("** Error: unrecognized language '%s'\n", prj_get_language());
+		return 0;
+	}
+}
+
+
 static int writeCombine()
 {
 	const char* path;
@@ -126,7 +153,8 @@ static int writeCombine()
 	/* Finish */
 	io_print("  </Configurations>\n");
 	io_print("</Combine>");
-	io_closefile();
+	if (!io_closefile())
+		return 0;
 
 	/* MonoDevelop adds another file */
 	if (sharpdev_target == MONODEV)
@@ -139,7 +167,7 @@ static int writeCombine()
 		io_print("  <RelativeOutputPath>%s</RelativeOutputPath>\n", prj_get_bindir());
 		io_print("</MonoDevelopSolution>\n");
 
-		io_closefile();
+		return io_closefile();
 	}
 
 	return 1;
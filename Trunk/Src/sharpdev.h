@@ -23,4 +23,5 @@ int sharpdev_cs();
 #define MONODEV   1
 
 extern int sharpdev_target;
-extern int sharpdev_warncontent;
+extern const char* sharpdev_dotnet;
+extern THREAD_LOCAL int sharpdev_warncontent;
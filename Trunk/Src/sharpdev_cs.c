@@ -21,7 +21,7 @@
 #include "sharpdev.h"
 #include "os.h"
 
-static char buffer[8192];
+static THREAD_LOCAL char buffer[8192];
 
 static void listFiles(const char* path, int stage);
 static void printFile(const char* file);
@@ -49,27 +49,24 @@ int sharpdev_cs()
 	}
 
 	/* Figure out what .NET environment I'm using */
-	if (g_dotnet == NULL)
-		g_dotnet = (os_is("windows") || sharpdev_target == MONODEV) ? "ms" : "mono";
-	
-	if (strcmp(g_dotnet, "ms") == 0)
+	if (strcmp(sharpdev_dotnet, "ms") == 0)
 	{
 		runtime = "MsNet";
 		csc = "Csc";
 	}
-	else if (strcmp(g_dotnet, "mono") == 0)
+	else if (strcmp(sharpdev_dotnet, "mono") == 0)
 	{
 		runtime = "Mono";
 		csc = "Mcs";
 	}
-	else if (strcmp(g_dotnet, "pnet") == 0)
+	else if (strcmp(sharpdev_dotnet, "pnet") == 0)
 	{
 		printf("** Error: SharpDevelop does not yet support Portable.NET\n");
 		return 0;
 	}
 	else
 	{
-		printf("** Error: unknown .NET runtime '%s'\n", g_dotnet);
+		printf("** Error: unknown .NET runtime '%s'\n", sharpdev_dotnet);
 		return 0;
 	}
 
@@ -106,14 +103,14 @@ int sharpdev_cs()
 
 		prj_select_config(i);
 
-		optimized = prj_has_flag("optimize") || prj_has_flag("optimize-size") || prj_has_flag("optimize-speed");
+		optimized = prj_has_flag(FLAG_OPTIMIZE) || prj_has_flag(FLAG_OPTIMIZE_SIZE) || prj_has_flag(FLAG_OPTIMIZE_SPEED);
 
-		io_print("    <Configuration runwithwarnings=\"%s\" name=\"%s\">\n", prj_has_flag("fatal-warnings") ? "False" : "True", prj_get_cfgname());
+		io_print("    <Configuration runwithwarnings=\"%s\" name=\"%s\">\n", prj_has_flag(FLAG_FATAL_WARNINGS) ? "False" : "True", prj_get_cfgname());
 		io_print("      <CodeGeneration runtime=\"%s\" compiler=\"%s\" compilerversion=\"\" ", runtime, csc);
 		io_print("warninglevel=\"4\" nowarn=\"\" ");  /* C# defaults to highest warning level */
-		io_print("includedebuginformation=\"%s\" ", prj_has_flag("no-symbols") ? "False" : "True"); 
+		io_print("includedebuginformation=\"%s\" ", prj_has_flag(FLAG_NO_SYMBOLS) ? "False" : "True"); 
 		io_print("optimize=\"%s\" ", optimized ? "True" : "False");
-		io_print("unsafecodeallowed=\"%s\" ", prj_has_flag("unsafe") ? "True" : "False");
+		io_print("unsafecodeallowed=\"%s\" ", prj_has_flag(FLAG_UNSAFE) ? "True" : "False");
 		io_print("generateoverflowchecks=\"%s\" ", optimized ? "False" : "True");
 		io_print("mainclass=\"\" ");
 		io_print("target=\"%s\" ", kind); 
@@ -142,8 +139,7 @@ int sharpdev_cs()
 	io_print("  </Configurations>\n");
 	io_print("</Project>\n");
 
-	io_closefile();
-	return 1;
+	return io_closefile();
 }
 
 
@@ -247,8 +243,7 @@ static void printFile(const char* file)
 
 static const char* listReferences(const char* name)
 {
-	int i;
-	int isSibling = 0;
+	int isSibling;
 	const char* fileName = path_getname(name);
 
 	strcpy(buffer," type=\"");
@@ -261,15 +256,7 @@ static const char* listReferences(const char* name)
 	 * reference paths to see if I can find the DLL and if so I consider
 	 * it local. If not, I consider it in the GAC. Seems to work so far */
 
-	for (i = 0; i < prj_get_numpackages(); ++i)
-	{
-		if (matches(prj_get_pkgname_for(i), name))
-		{
-			isSibling = 1;
-			break;
-		}
-	}
-		
+	isSibling = (prj_find_package(name) >= 0);
 	if(isSibling)
 	{
 		strcat(buffer, "Project\"");
@@ -0,0 +1,557 @@
+/**********************************************************************
+ * Premake - snapshot.c
+ * Saves the exported project model to a file and loads it back.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "premake.h"
+#include "hash.h"
+#include "os.h"
+#include "snapshot.h"
+
+/* The snapshot is a copy of the model in one block, with every pointer
+ * stored as an offset from the start of the block (0 for NULL). Loading
+ * reads the block into the project arena and turns the offsets back into
+ * pointers in place, so nothing is allocated per object and strings are
+ * not copied. Lists keep the same layout as prj_newlist(). The layout
+ * follows the in-memory structures, so a snapshot is only usable by a
+ * build with the same version, byte order and pointer size. The paths
+ * that prj_resolve_paths() works out are not saved, but resolved again
+ * once the model is loaded. */
+
+#define SNAPSHOT_VERSION  2
+#define SNAPSHOT_ORDER    0x01020304
+
+typedef struct tagSnapshotHeader
+{
+	char     magic[4];
+	unsigned version;
+	unsigned order;
+	unsigned ptrsize;
+	unsigned size;
+	unsigned os;
+	unsigned project;
+} SnapshotHeader;
+
+#define OFFSET(T, o)  (T)(size_t)(o)
+
+static char*    my_data;
+static unsigned my_size;
+static unsigned my_capacity;
+static Hash*    my_strings;
+static unsigned* my_prjconfigs;
+static int      my_valid;
+
+
+/************************************************************************
+ * Writing. Children are always written before their parents, since the
+ * block may move as it grows
+ ***********************************************************************/
+
+static unsigned reserve(unsigned size, unsigned align)
+{
+	unsigned offset = (my_size + align - 1) & ~(align - 1);
+	if (offset + size > my_capacity)
+	{
+		while (offset + size > my_capacity)
+			my_capacity *= 2;
+		my_data = (char*)realloc(my_data, my_capacity);
+	}
+
+	memset(my_data + my_size, 0, offset + size - my_size);
+	my_size = offset + size;
+	return offset;
+}
+
+static unsigned putBytes(const void* bytes, unsigned size)
+{
+	unsigned offset = reserve(size, sizeof(void*));
+	memcpy(my_data + offset, bytes, size);
+	return offset;
+}
+
+static unsigned putString(const char* str)
+{
+	unsigned offset;
+	if (str == NULL)
+		return 0;
+
+	/* Each distinct string is stored once */
+	offset = (unsigned)(size_t)hash_find(my_strings, str);
+	if (offset == 0)
+	{
+		offset = reserve(strlen(str) + 1, 1);
+		strcpy(my_data + offset, str);
+		hash_insert(my_strings, str, OFFSET(void*, offset));
+	}
+	return offset;
+}
+
+static unsigned putStringItem(void* item)
+{
+	return putString((const char*)item);
+}
+
+static unsigned putList(void** list, unsigned (*put)(void*))
+{
+	unsigned* items;
+	unsigned offset;
+	void** copy;
+	int len, i;
+
+	if (list == NULL)
+		return 0;
+
+	len = prj_getlistsize(list);
+	items = (unsigned*)malloc(sizeof(unsigned) * (len + 1));
+	for (i = 0; i < len; ++i)
+		items[i] = put(list[i]);
+
+	offset = reserve(PRJ_LIST_HEADER + sizeof(void*) * (len + 1), sizeof(void*)) + PRJ_LIST_HEADER;
+	*(int*)(my_data + offset - PRJ_LIST_HEADER) = len;
+	copy = (void**)(my_data + offset);
+	for (i = 0; i < len; ++i)
+		copy[i] = OFFSET(void*, items[i]);
+	copy[len] = NULL;
+
+	free(items);
+	return offset;
+}
+
+static unsigned putStrings(const char** list)
+{
+	return putList((void**)list, putStringItem);
+}
+
+static unsigned putOption(void* item)
+{
+	Option* option = (Option*)item;
+	Option copy;
+	copy.flag = OFFSET(const char*, putString(option->flag));
+	copy.desc = OFFSET(const char*, putString(option->desc));
+	return putBytes(&copy, sizeof(Option));
+}
+
+static unsigned putPrjConfig(void* item)
+{
+	PrjConfig* config = (PrjConfig*)item;
+	PrjConfig copy;
+	copy.name   = OFFSET(const char*, putString(config->name));
+	copy.bindir = OFFSET(const char*, putString(config->bindir));
+	copy.libdir = OFFSET(const char*, putString(config->libdir));
+	return putBytes(&copy, sizeof(PrjConfig));
+}
+
+static unsigned putFileConfig(void* item)
+{
+	FileConfig* fconfig = (FileConfig*)item;
+	FileConfig copy;
+	copy.buildaction = OFFSET(const char*, putString(fconfig->buildaction));
+	return putBytes(&copy, sizeof(FileConfig));
+}
+
+static unsigned putPkgConfig(void* item)
+{
+	PkgConfig* config = (PkgConfig*)item;
+	PkgConfig copy;
+	int i;
+
+	memset(&copy, 0, sizeof(PkgConfig));
+
+	/* Package configurations point at the shared project configurations,
+	 * which have already been written */
+	for (i = 0; project->configs[i] != NULL; ++i)
+	{
+		if (project->configs[i] == config->prjConfig)
+			copy.prjConfig = OFFSET(PrjConfig*, my_prjconfigs[i]);
+	}
+
+	copy.buildopts   = OFFSET(const char**, putStrings(config->buildopts));
+	copy.defines     = OFFSET(const char**, putStrings(config->defines));
+	copy.extension   = OFFSET(const char*,  putString(config->extension));
+	copy.files       = OFFSET(const char**, putStrings(config->files));
+	copy.flags       = OFFSET(const char**, putStrings(config->flags));
+	copy.flagbits    = config->flagbits;
+	copy.incpaths    = OFFSET(const char**, putStrings(config->incpaths));
+	copy.libpaths    = OFFSET(const char**, putStrings(config->libpaths));
+	copy.linkopts    = OFFSET(const char**, putStrings(config->linkopts));
+	copy.links       = OFFSET(const char**, putStrings(config->links));
+	copy.objdir      = OFFSET(const char*,  putString(config->objdir));
+	copy.prefix      = OFFSET(const char*,  putString(config->prefix));
+	copy.target      = OFFSET(const char*,  putString(config->target));
+	copy.kind        = OFFSET(const char*,  putString(config->kind));
+	copy.fileconfigs = OFFSET(FileConfig**, putList((void**)config->fileconfigs, putFileConfig));
+	return putBytes(&copy, sizeof(PkgConfig));
+}
+
+static unsigned putPackage(void* item)
+{
+	Package* package = (Package*)item;
+	Package copy;
+
+	memset(&copy, 0, sizeof(Package));
+	copy.index   = package->index;
+	copy.name    = OFFSET(const char*, putString(package->name));
+	copy.path    = OFFSET(const char*, putString(package->path));
+	copy.script  = OFFSET(const char*, putString(package->script));
+	copy.lang    = OFFSET(const char*, putString(package->lang));
+	copy.kind    = OFFSET(const char*, putString(package->kind));
+	copy.objdir  = OFFSET(const char*, putString(package->objdir));
+	copy.url     = OFFSET(const char*, putString(package->url));
+	copy.configs = OFFSET(PkgConfig**, putList((void**)package->configs, putPkgConfig));
+	return putBytes(&copy, sizeof(Package));
+}
+
+static unsigned putProject()
+{
+	Project copy;
+	int i;
+
+	memset(&copy, 0, sizeof(Project));
+	copy.name    = OFFSET(const char*, putString(project->name));
+	copy.path    = OFFSET(const char*, putString(project->path));
+	copy.script  = OFFSET(const char*, putString(project->script));
+	copy.options = OFFSET(Option**, putList((void**)project->options, putOption));
+	copy.configs = OFFSET(PrjConfig**, putList((void**)project->configs, putPrjConfig));
+
+	/* Remember where the project configurations went */
+	my_prjconfigs = (unsigned*)malloc(sizeof(unsigned) * (prj_get_numconfigs() + 1));
+	for (i = 0; i < prj_get_numconfigs(); ++i)
+		my_prjconfigs[i] = (unsigned)(size_t)((void**)(my_data + (size_t)copy.configs))[i];
+
+	copy.packages = OFFSET(Package**, putList((void**)project->packages, putPackage));
+	free(my_prjconfigs);
+	return putBytes(&copy, sizeof(Project));
+}
+
+
+int snapshot_save(const char* filename)
+{
+	SnapshotHeader header;
+	FILE* file;
+	int result;
+
+	my_capacity = 64 * 1024;
+	my_data = (char*)malloc(my_capacity);
+	my_size = 0;
+	my_strings = hash_create();
+
+	/* The header goes first, so that no object lives at offset 0 */
+	reserve(sizeof(SnapshotHeader), sizeof(void*));
+	memcpy(header.magic, "PMKM", 4);
+	header.version = SNAPSHOT_VERSION;
+	header.order   = SNAPSHOT_ORDER;
+	header.ptrsize = sizeof(void*);
+	header.os      = putString(os_get());
+	header.project = putProject();
+
+	/* End on a zero byte, so every string is terminated within the block */
+	reserve(1, 1);
+	header.size = my_size;
+	memcpy(my_data, &header, sizeof(SnapshotHeader));
+
+	result = 0;
+	file = fopen(filename, "wb");
+	if (file != NULL)
+	{
+		result = (fwrite(my_data, 1, my_size, file) == my_size);
+		result = (fclose(file) == 0) && result;
+	}
+	if (!result)
+		printf("** Unable to write the project model to '%s'\n", filename);
+	else if (g_verbose)
+		printf("Saved the project model to '%s' (%u bytes)\n", filename, my_size);
+
+	hash_destroy(my_strings);
+	free(my_data);
+	my_data = NULL;
+	return result;
+}
+
+
+/************************************************************************
+ * Loading. Each offset is checked against the size of the block before
+ * it is turned into a pointer
+ ***********************************************************************/
+
+static void* relocate(const void* ptr, unsigned size)
+{
+	size_t offset = (size_t)ptr;
+	if (offset == 0)
+		return NULL;
+
+	/* Everything but strings is aligned for its pointers */
+	if (offset < sizeof(SnapshotHeader) || size > my_size || offset > my_size - size ||
+	    (size > 1 && offset % sizeof(void*) != 0))
+	{
+		my_valid = 0;
+		return NULL;
+	}
+	return my_data + offset;
+}
+
+static void** relocateList(void** list, unsigned itemsize)
+{
+	size_t pos;
+	int len, i;
+
+	list = (void**)relocate(list, sizeof(void*));
+	pos  = (list != NULL) ? (size_t)((char*)list - my_data) : 0;
+	if (pos < sizeof(SnapshotHeader) + PRJ_LIST_HEADER)
+	{
+		my_valid = 0;
+		return NULL;
+	}
+
+	/* The loaders and generators walk lists to their terminator; relocate()
+	 * already guaranteed room for one pointer, so this can't underflow */
+	len = prj_getlistsize(list);
+	if (len < 0 || (size_t)len > (my_size - pos) / sizeof(void*) - 1 || list[len] != NULL)
+	{
+		my_valid = 0;
+		return NULL;
+	}
+
+	for (i = 0; i < len; ++i)
+	{
+		list[i] = relocate(list[i], itemsize);
+		if (list[i] == NULL)
+			my_valid = 0;
+	}
+	return list;
+}
+
+#define RELOCATE_STRING(s)  (s) = (const char*)relocate(s, 1)
+#define RELOCATE_STRINGS(l) (l) = (const char**)relocateList((void**)(l), 1)
+#define RELOCATE_LIST(T, l) (l) = (T**)relocateList((void**)(l), sizeof(T))
+
+static void relocatePkgConfig(PkgConfig* config)
+{
+	int count, i;
+
+	config->prjConfig = (PrjConfig*)relocate(config->prjConfig, sizeof(PrjConfig));
+	RELOCATE_STRINGS(config->buildopts);
+	RELOCATE_STRINGS(config->defines);
+	RELOCATE_STRING(config->extension);
+	RELOCATE_STRINGS(config->files);
+	RELOCATE_STRINGS(config->flags);
+	RELOCATE_STRINGS(config->incpaths);
+	RELOCATE_STRINGS(config->libpaths);
+	RELOCATE_STRINGS(config->linkopts);
+	RELOCATE_STRINGS(config->links);
+	RELOCATE_STRING(config->objdir);
+	RELOCATE_STRING(config->prefix);
+	RELOCATE_STRING(config->target);
+	RELOCATE_STRING(config->kind);
+	RELOCATE_LIST(FileConfig, config->fileconfigs);
+	config->fileIndex = NULL;
+	if (!my_valid || config->prjConfig == NULL || config->target == NULL)
+	{
+		my_valid = 0;
+		return;
+	}
+
+	/* There is one file configuration for each file */
+	count = prj_getlistsize((void**)config->files);
+	if (prj_getlistsize((void**)config->fileconfigs) != count)
+	{
+		my_valid = 0;
+		return;
+	}
+	for (i = 0; i < count; ++i)
+		RELOCATE_STRING(config->fileconfigs[i]->buildaction);
+}
+
+static void relocateProject(Project* copy)
+{
+	int numOptions, numConfigs, numPackages;
+	int i, j;
+
+	RELOCATE_STRING(copy->name);
+	RELOCATE_STRING(copy->path);
+	RELOCATE_STRING(copy->script);
+	RELOCATE_LIST(Option, copy->options);
+	RELOCATE_LIST(PrjConfig, copy->configs);
+	RELOCATE_LIST(Package, copy->packages);
+	if (!my_valid || copy->name == NULL || copy->path == NULL)
+	{
+		my_valid = 0;
+		return;
+	}
+
+	numOptions  = prj_getlistsize((void**)copy->options);
+	numConfigs  = prj_getlistsize((void**)copy->configs);
+	numPackages = prj_getlistsize((void**)copy->packages);
+	if (numConfigs == 0)
+	{
+		my_valid = 0;
+		return;
+	}
+
+	for (i = 0; i < numOptions; ++i)
+	{
+		RELOCATE_STRING(copy->options[i]->flag);
+		RELOCATE_STRING(copy->options[i]->desc);
+	}
+
+	for (i = 0; i < numConfigs; ++i)
+	{
+		RELOCATE_STRING(copy->configs[i]->name);
+		RELOCATE_STRING(copy->configs[i]->bindir);
+		RELOCATE_STRING(copy->configs[i]->libdir);
+		if (copy->configs[i]->name == NULL)
+			my_valid = 0;
+	}
+
+	for (i = 0; my_valid && i < numPackages; ++i)
+	{
+		Package* package = copy->packages[i];
+		RELOCATE_STRING(package->name);
+		RELOCATE_STRING(package->path);
+		RELOCATE_STRING(package->script);
+		RELOCATE_STRING(package->lang);
+		RELOCATE_STRING(package->kind);
+		RELOCATE_STRING(package->objdir);
+		RELOCATE_STRING(package->url);
+		RELOCATE_LIST(PkgConfig, package->configs);
+		package->data = NULL;
+
+		/* The generators take these as given, and find a package's own
+		 * entries by its index */
+		if (!my_valid || package->name == NULL || package->path == NULL ||
+		    package->kind == NULL || package->lang == NULL || package->index != i)
+		{
+			my_valid = 0;
+			return;
+		}
+
+		/* Every package has a configuration for each project one */
+		if (prj_getlistsize((void**)package->configs) != numConfigs)
+		{
+			my_valid = 0;
+			return;
+		}
+		for (j = 0; my_valid && j < numConfigs; ++j)
+			relocatePkgConfig(package->configs[j]);
+	}
+}
+
+
+/* The model was exported for a particular OS, which the generators need
+ * to agree with. The name is copied out of the snapshot block, which
+ * goes away with the model */
+static int restoreOS(const char* name)
+{
+	static char os[16];
+	if (name == NULL || strlen(name) >= sizeof(os))
+		return 0;
+	strcpy(os, name);
+	return os_set(os);
+}
+
+
+int snapshot_load(const char* filename)
+{
+	SnapshotHeader header;
+	Project* copy;
+	FILE* file;
+	int result;
+
+	file = fopen(filename, "rb");
+	if (file == NULL)
+	{
+		printf("** Unable to open the project model '%s'\n", filename);
+		return 0;
+	}
+
+	result = (fread(&header, sizeof(SnapshotHeader), 1, file) == 1);
+	if (result)
+	{
+		result = memcmp(header.magic, "PMKM", 4) == 0 &&
+		         header.version == SNAPSHOT_VERSION &&
+		         header.order   == SNAPSHOT_ORDER &&
+		         header.ptrsize == sizeof(void*) &&
+		         header.size    >  sizeof(SnapshotHeader);
+	}
+
+	/* The block is the whole file; don't trust a size that isn't */
+	if (result)
+	{
+		result = (fseek(file, 0, SEEK_END) == 0 && ftell(file) == (long)header.size);
+	}
+
+	/* Read the whole block into the project arena */
+	if (result)
+	{
+		/* Start from an empty model, which prj_close() can release if
+		 * the snapshot turns out to be broken */
+		prj_open();
+		project->options  = (Option**)prj_newlist(0);
+		project->configs  = (PrjConfig**)prj_newlist(0);
+		project->packages = (Package**)prj_newlist(0);
+
+		my_size = header.size;
+		my_data = (char*)prj_alloc(my_size);
+		rewind(file);
+		result = (fread(my_data, 1, my_size, file) == my_size) && (my_data[my_size - 1] == '\0');
+	}
+	fclose(file);
+
+	if (result)
+	{
+		my_valid = 1;
+		copy = (Project*)relocate(OFFSET(void*, header.project), sizeof(Project));
+		if (copy != NULL)
+			relocateProject(copy);
+		result = my_valid && restoreOS((const char*)relocate(OFFSET(void*, header.os), 1));
+	}
+
+	if (result)
+	{
+		int i, j, k;
+
+		project->name     = copy->name;
+		project->path     = copy->path;
+		project->script   = copy->script;
+		project->options  = copy->options;
+		project->configs  = copy->configs;
+		project->packages = copy->packages;
+		prj_index_packages();
+
+		/* Per-file queries come in by name; a later duplicate wins */
+		for (i = 0; i < prj_get_numpackages(); ++i)
+		{
+			for (j = 0; j < prj_get_numconfigs(); ++j)
+			{
+				PkgConfig* config = project->packages[i]->configs[j];
+				config->fileIndex = hash_create();
+				for (k = 0; config->files[k] != NULL; ++k)
+					hash_insert(config->fileIndex, config->files[k], config->fileconfigs[k]);
+			}
+		}
+
+		prj_resolve_paths();
+	}
+	else
+	{
+		printf("** '%s' is not a project model saved by this version of Premake\n", filename);
+		prj_close();
+	}
+
+	my_data = NULL;
+	return result;
+}
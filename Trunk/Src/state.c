@@ -0,0 +1,537 @@
+/**********************************************************************
+ * Premake - state.c
+ * Remembers what each package was generated from, between runs.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "premake.h"
+#include "hash.h"
+#include "jobs.h"
+#include "os.h"
+#include "state.h"
+
+/* The state file sits next to the root output files and holds a
+ * section for each target that has been generated:
+ *
+ *   premake-state 2
+ *   target gnu
+ *   package 5d1e0a4f09b2c7e3 src/MyPackage
+ *   file src/MyPackage.make
+ *
+ * Packages are known by their path relative to the script plus their
+ * name, so packages with the same name in different directories keep
+ * their own entries. Each package line carries a digest of everything
+ * the package's files are made from: its part of the model, the
+ * packages it links to, the generator and its options. Nothing in it
+ * depends on where the tree is, so a copied or moved tree is not
+ * regenerated. A package is only written again when its digest changes
+ * or one of its files has gone missing. */
+
+static const char* FILE_HEADER = "premake-state 2";
+
+typedef struct tagPkgState
+{
+	char*  key;
+	char   digest[17];
+	char** files;
+	int    numFiles;
+	int    written;
+} PkgState;
+
+typedef struct tagDigest
+{
+	unsigned long a;
+	unsigned long b;
+} Digest;
+
+static const char* my_target  = NULL;
+static char**      my_others  = NULL;
+static int         my_numOthers;
+static PkgState*   my_old     = NULL;
+static int         my_numOld;
+static Hash*       my_oldIndex = NULL;
+static PkgState*   my_new     = NULL;
+static int         my_numNew;
+static int       (*my_job)(int i);
+
+static THREAD_LOCAL int my_current = -1;
+
+static void  addFile(PkgState* state, const char* path);
+static char* copyString(const char* str);
+static void  digestPackages();
+static void  freeStates(PkgState* states, int count);
+static void  onFileOpened(const char* path);
+static void  readState();
+static int   readLine(FILE* file, char* buffer, int size);
+static int   runJob(int i);
+
+
+/************************************************************************
+ * Start tracking a target: load what was recorded the last time it was
+ * generated and work out what each package is made from now. A missing
+ * or unreadable file just means every package is written.
+ ***********************************************************************/
+
+int state_open(const char* target)
+{
+	int i;
+
+	state_close(0);
+
+	my_target = target;
+	my_numNew = prj_get_numpackages();
+	my_new = (PkgState*)calloc(my_numNew + 1, sizeof(PkgState));
+	for (i = 0; i < my_numNew; ++i)
+	{
+		Package* package = project->packages[i];
+		my_new[i].key = copyString(path_combine(package->path, package->name));
+	}
+
+	readState();
+	digestPackages();
+
+	io_setlistener(onFileOpened);
+	return 1;
+}
+
+
+/************************************************************************
+ * Stop tracking the target. After a successful run the state file is
+ * rewritten; after a failure it is left alone, so the packages that
+ * were changed will be written again next time.
+ ***********************************************************************/
+
+void state_close(int succeeded)
+{
+	FILE* file;
+	int i, j, written = 0;
+
+	if (my_new == NULL)
+		return;
+
+	io_setlistener(NULL);
+
+	if (succeeded)
+	{
+		file = fopen(state_getfilename(), "w");
+		if (file != NULL)
+		{
+			fprintf(file, "%s\n", FILE_HEADER);
+			for (i = 0; i < my_numOthers; ++i)
+				fprintf(file, "%s\n", my_others[i]);
+
+			fprintf(file, "target %s\n", my_target);
+			for (i = 0; i < my_numNew; ++i)
+			{
+				fprintf(file, "package %s %s\n", my_new[i].digest, my_new[i].key);
+				for (j = 0; j < my_new[i].numFiles; ++j)
+					fprintf(file, "file %s\n", my_new[i].files[j]);
+				written += my_new[i].written;
+			}
+			fclose(file);
+		}
+		else
+		{
+			printf("** Unable to write state file '%s'\n", state_getfilename());
+		}
+
+		if (written < my_numNew)
+			printf("%d of %d packages regenerated\n", written, my_numNew);
+	}
+
+	for (i = 0; i < my_numOthers; ++i)
+		free(my_others[i]);
+	free(my_others);
+	my_others = NULL;
+	my_numOthers = 0;
+
+	hash_destroy(my_oldIndex);
+	my_oldIndex = NULL;
+	freeStates(my_old, my_numOld);
+	my_old = NULL;
+	my_numOld = 0;
+	freeStates(my_new, my_numNew);
+	my_new = NULL;
+	my_numNew = 0;
+}
+
+
+/************************************************************************
+ * Where the state is kept, beside the project's root output files
+ ***********************************************************************/
+
+const char* state_getfilename()
+{
+	static char buffer[8192];
+	strcpy(buffer, path_join(prj_get_path(), ".premake", "state"));
+	return buffer;
+}
+
+
+/************************************************************************
+ * Call job(i) for each package that has changed, as jobs_run() would.
+ * Packages that haven't changed keep the files they had. Without an
+ * open state, every package is written.
+ ***********************************************************************/
+
+int state_run(int count, int (*job)(int i))
+{
+	if (my_new == NULL || count != my_numNew)
+		return jobs_run(count, job);
+
+	my_job = job;
+	return jobs_run(count, runJob);
+}
+
+
+static int runJob(int i)
+{
+	PkgState* old = (PkgState*)hash_find(my_oldIndex, my_new[i].key);
+	int result, j;
+
+	if (old != NULL && matches(old->digest, my_new[i].digest))
+	{
+		for (j = 0; j < old->numFiles; ++j)
+		{
+			if (!io_fileexists(old->files[j]))
+				break;
+		}
+
+		if (j == old->numFiles)
+		{
+			for (j = 0; j < old->numFiles; ++j)
+				addFile(&my_new[i], old->files[j]);
+			return 1;
+		}
+	}
+
+	my_current = i;
+	my_new[i].written = 1;
+	result = my_job(i);
+	my_current = -1;
+	return result;
+}
+
+
+/* Files opened by a package's job belong to that package */
+static void onFileOpened(const char* path)
+{
+	if (my_current >= 0)
+		addFile(&my_new[my_current], path);
+}
+
+
+/************************************************************************
+ * Digests: two independent 32-bit string hashes side by side
+ ***********************************************************************/
+
+static void digestInit(Digest* digest)
+{
+	digest->a = 2166136261UL;
+	digest->b = 0;
+}
+
+static void digestBytes(Digest* digest, const char* bytes, int len)
+{
+	int i;
+	for (i = 0; i < len; ++i)
+	{
+		unsigned long c = (unsigned char)bytes[i];
+		digest->a = ((digest->a ^ c) * 16777619UL) & 0xFFFFFFFFUL;
+		digest->b = (c + (digest->b << 6) + (digest->b << 16) - digest->b) & 0xFFFFFFFFUL;
+	}
+}
+
+static void digestString(Digest* digest, const char* str)
+{
+	/* Strings are kept apart by their terminators; NULL is its own value */
+	if (str != NULL)
+		digestBytes(digest, str, strlen(str) + 1);
+	else
+		digestBytes(digest, "\1", 2);
+}
+
+static void digestNumber(Digest* digest, unsigned long value)
+{
+	char buffer[32];
+	sprintf(buffer, "%lu", value);
+	digestString(digest, buffer);
+}
+
+static void digestList(Digest* digest, const char** list)
+{
+	digestNumber(digest, prj_getlistsize((void**)list));
+	for (; *list != NULL; ++list)
+		digestString(digest, *list);
+}
+
+static void digestFormat(Digest* digest, char* buffer)
+{
+	sprintf(buffer, "%08lx%08lx", digest->a, digest->b);
+}
+
+
+/************************************************************************
+ * Work out the digest of each package
+ ***********************************************************************/
+
+static void digestPackage(Digest* digest, Package* package)
+{
+	int i, j;
+
+	digestString(digest, package->name);
+	digestString(digest, package->path);
+	digestString(digest, package->script);
+	digestString(digest, package->lang);
+	digestString(digest, package->kind);
+	digestString(digest, package->objdir);
+	digestString(digest, package->url);
+
+	for (i = 0; package->configs[i] != NULL; ++i)
+	{
+		PkgConfig* config = package->configs[i];
+		digestString(digest, config->prjConfig->name);
+		digestList(digest, config->buildopts);
+		digestList(digest, config->defines);
+		digestString(digest, config->extension);
+		digestList(digest, config->files);
+		digestList(digest, config->flags);
+		digestNumber(digest, config->flagbits);
+		digestList(digest, config->incpaths);
+		digestList(digest, config->libpaths);
+		digestList(digest, config->linkopts);
+		digestList(digest, config->links);
+		digestString(digest, config->objdir);
+		digestString(digest, config->prefix);
+		digestString(digest, config->target);
+		digestString(digest, config->kind);
+		digestString(digest, config->bindir);
+		digestString(digest, config->libdir);
+		digestString(digest, config->objpath);
+		digestString(digest, config->outdir);
+		digestString(digest, config->targetpath);
+		digestString(digest, config->targetname);
+		for (j = 0; config->fileconfigs[j] != NULL; ++j)
+			digestString(digest, config->fileconfigs[j]->buildaction);
+	}
+}
+
+/* .NET references that aren't sibling packages are looked for on disk */
+static void digestAssemblies(Digest* digest, Package* package)
+{
+	char path[8192];
+	const char** link;
+	const char** dir;
+	int i;
+
+	if (!matches(package->lang, "c#"))
+		return;
+
+	for (i = 0; package->configs[i] != NULL; ++i)
+	{
+		PkgConfig* config = package->configs[i];
+		for (link = config->links; *link != NULL; ++link)
+		{
+			if (prj_find_package(*link) >= 0)
+				continue;
+
+			for (dir = config->libpaths; *dir != NULL; ++dir)
+			{
+				path_combine_r(package->path, *dir, path);
+				digestNumber(digest, io_fileexists(path_join(path, *link, "dll")));
+			}
+
+			path_combine_r(package->path, config->prjConfig->bindir, path);
+			digestNumber(digest, io_fileexists(path_join(path, *link, "dll")));
+		}
+	}
+}
+
+static void digestPackages()
+{
+	Digest  digest, common;
+	char*   own;
+	char**  where;
+	char    path[8192];
+	const char** link;
+	int i, j;
+
+	/* Everything that goes into every package */
+	digestInit(&common);
+	digestString(&common, FILE_HEADER);
+	digestString(&common, VERSION);
+	digestString(&common, my_target);
+	digestString(&common, os_get());
+	digestString(&common, g_cc);
+	digestString(&common, g_dotnet);
+	digestNumber(&common, g_verbose);
+	digestString(&common, project->name);
+	digestString(&common, project->path);
+	digestString(&common, project->script);
+	for (i = 0; project->configs[i] != NULL; ++i)
+	{
+		digestString(&common, project->configs[i]->name);
+		digestString(&common, project->configs[i]->bindir);
+		digestString(&common, project->configs[i]->libdir);
+	}
+
+	/* Each package on its own, and where it lives */
+	own = (char*)malloc(17 * (my_numNew + 1));
+	where = (char**)malloc(sizeof(char*) * (my_numNew + 1));
+	for (i = 0; i < my_numNew; ++i)
+	{
+		digestInit(&digest);
+		digestPackage(&digest, project->packages[i]);
+		digestFormat(&digest, own + 17 * i);
+		where[i] = copyString(path_absolute(project->packages[i]->path));
+	}
+	path_absolute_r(project->path, path);
+
+	/* Then add the packages it links to, and the packages it shares a
+	 * directory with, which decide how its files are named */
+	for (i = 0; i < my_numNew; ++i)
+	{
+		Package* package = project->packages[i];
+
+		digest = common;
+		digestString(&digest, own + 17 * i);
+		digestNumber(&digest, matches(where[i], path));
+		for (j = 0; j < my_numNew; ++j)
+		{
+			if (j != i && matches(where[i], where[j]))
+				digestString(&digest, project->packages[j]->name);
+		}
+
+		for (j = 0; package->configs[j] != NULL; ++j)
+		{
+			for (link = package->configs[j]->links; *link != NULL; ++link)
+			{
+				int sibling = prj_find_package(*link);
+				if (sibling >= 0)
+					digestString(&digest, own + 17 * sibling);
+			}
+		}
+
+		digestAssemblies(&digest, package);
+		digestFormat(&digest, my_new[i].digest);
+	}
+
+	for (i = 0; i < my_numNew; ++i)
+		free(where[i]);
+	free(where);
+	free(own);
+}
+
+
+/************************************************************************
+ * Load the previous state. Sections for other targets are kept as
+ * they are, to be written back out.
+ ***********************************************************************/
+
+static void readState()
+{
+	char buffer[8192];
+	FILE* file;
+	int mine = 0;
+
+	my_oldIndex = hash_create();
+
+	file = fopen(state_getfilename(), "r");
+	if (file == NULL)
+		return;
+
+	/* An older or unknown file is replaced */
+	if (!readLine(file, buffer, 8192) || !matches(buffer, FILE_HEADER))
+	{
+		fclose(file);
+		return;
+	}
+
+	while (readLine(file, buffer, 8192))
+	{
+		if (strncmp(buffer, "target ", 7) == 0)
+			mine = matches(buffer + 7, my_target);
+
+		if (!mine)
+		{
+			my_others = (char**)realloc(my_others, sizeof(char*) * (my_numOthers + 1));
+			my_others[my_numOthers++] = copyString(buffer);
+		}
+		else if (strncmp(buffer, "package ", 8) == 0 && strlen(buffer) > 25 && buffer[24] == ' ')
+		{
+			PkgState* state;
+			my_old = (PkgState*)realloc(my_old, sizeof(PkgState) * (my_numOld + 1));
+			state = &my_old[my_numOld++];
+			memset(state, 0, sizeof(PkgState));
+			memcpy(state->digest, buffer + 8, 16);
+			state->key = copyString(buffer + 25);
+		}
+		else if (strncmp(buffer, "file ", 5) == 0 && my_numOld > 0)
+		{
+			addFile(&my_old[my_numOld - 1], buffer + 5);
+		}
+	}
+
+	fclose(file);
+
+	/* Only index once the array has stopped moving */
+	for (mine = 0; mine < my_numOld; ++mine)
+		hash_insert(my_oldIndex, my_old[mine].key, &my_old[mine]);
+}
+
+
+static void addFile(PkgState* state, const char* path)
+{
+	state->files = (char**)realloc(state->files, sizeof(char*) * (state->numFiles + 1));
+	state->files[state->numFiles++] = copyString(path);
+}
+
+
+static void freeStates(PkgState* states, int count)
+{
+	int i, j;
+	for (i = 0; i < count; ++i)
+	{
+		for (j = 0; j < states[i].numFiles; ++j)
+			free(states[i].files[j]);
+		free(states[i].files);
+		free(states[i].key);
+	}
+	free(states);
+}
+
+
+static char* copyString(const char* str)
+{
+	char* copy = (char*)malloc(strlen(str) + 1);
+	strcpy(copy, str);
+	return copy;
+}
+
+
+static int readLine(FILE* file, char* buffer, int size)
+{
+	int len;
+
+	if (fgets(buffer, size, file) == NULL)
+		return 0;
+
+	len = strlen(buffer);
+	while (len > 0 && (buffer[len - 1] == '\n' || buffer[len - 1] == '\r'))
+		buffer[--len] = '\0';
+	return 1;
+}
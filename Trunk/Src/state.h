@@ -0,0 +1,21 @@
+/**********************************************************************
+ * Premake - state.h
+ * Remembers what each package was generated from, between runs.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+void        state_close(int succeeded);
+const char* state_getfilename();
+int         state_open(const char* target);
+int         state_run(int count, int (*job)(int i));
@@ -24,10 +24,7 @@
 static char* CPP_EXT[] = { ".cc", ".cpp", ".cxx", ".c", ".s", NULL };
 
 /* Buffer for generators */
-char g_buffer[8192];
-
-/* Buffer for internal use */
-static char buffer[8192];
+THREAD_LOCAL char g_buffer[8192];
 
 
 /************************************************************************
@@ -73,17 +70,57 @@ static void stringify(char* src, char* dst, int count)
 
 void generateUUID(char* uuid)
 {
-	platform_getuuid(buffer);
+	char bytes[16];
+	platform_getuuid(bytes);
 
-	stringify(buffer, uuid, 4);
+	stringify(bytes, uuid, 4);
 	uuid[8] = '-';
-	stringify(buffer + 4, uuid + 9, 2);
+	stringify(bytes + 4, uuid + 9, 2);
 	uuid[13] = '-';
-	stringify(buffer + 6, uuid + 14, 2);
+	stringify(bytes + 6, uuid + 14, 2);
 	uuid[18] = '-';
-	stringify(buffer + 8, uuid + 19, 2);
+	stringify(bytes + 8, uuid + 19, 2);
 	uuid[23] = '-';
-	stringify(buffer + 10, uuid + 24, 6);
+	stringify(bytes + 10, uuid + 24, 6);
+	uuid[36] = '\0';
+}
+
+
+/************************************************************************
+ * Create a UUID from a name, which is the same every time the same name
+ * is used. Each group of four bytes is an FNV-1a hash of the name,
+ * started from a different seed
+ ***********************************************************************/
+
+void generateNamedUUID(const char* name, char* uuid)
+{
+	char bytes[16];
+	int  i, j;
+
+	for (i = 0; i < 4; ++i)
+	{
+		unsigned long hash = (2166136261UL + i * 0x9E3779B9UL) & 0xFFFFFFFFUL;
+		const char* ptr;
+		for (ptr = name; *ptr != '\0'; ++ptr)
+			hash = ((hash ^ (unsigned char)*ptr) * 16777619UL) & 0xFFFFFFFFUL;
+
+		for (j = 0; j < 4; ++j)
+			bytes[i * 4 + j] = (char)((hash >> (j * 8)) & 0xFF);
+	}
+
+	/* Mark it as a name-based (version 5) UUID */
+	bytes[6] = (char)((bytes[6] & 0x0F) | 0x50);
+	bytes[8] = (char)((bytes[8] & 0x3F) | 0x80);
+
+	stringify(bytes, uuid, 4);
+	uuid[8] = '-';
+	stringify(bytes + 4, uuid + 9, 2);
+	uuid[13] = '-';
+	stringify(bytes + 6, uuid + 14, 2);
+	uuid[18] = '-';
+	stringify(bytes + 8, uuid + 19, 2);
+	uuid[23] = '-';
+	stringify(bytes + 10, uuid + 24, 6);
 	uuid[36] = '\0';
 }
 
@@ -150,11 +187,12 @@ void print_list(const char** list, const char* prefix, const char* postfix, cons
 
 void print_source_tree(const char* path, void (*cb)(const char*, int))
 {
+	char buffer[8192];
 	const char** i;
 
 	/* Open an enclosing group */
 	strcpy(buffer, path);
-	if (buffer[strlen(buffer) - 1] == '/')   /* Trim off trailing path separator */
+	if (strlen(buffer) > 0 && buffer[strlen(buffer) - 1] == '/')   /* Trim off trailing path separator */
 		buffer[strlen(buffer) - 1] = '\0';
 	cb(buffer, WST_OPENGROUP);
 
@@ -183,15 +221,9 @@ void print_source_tree(const char* path, void (*cb)(const char*, int))
 						break;
 				}
 
+				/* Not processed earlier, process it now */
 				if (i == j)
-				{
-					/* Not processed earlier, process it now. Make a local copy
-					 * because 'buffer' will be reused in the next call */
-					char* newpath = (char*)malloc(strlen(buffer) + 1);
-					strcpy(newpath, buffer);
-					print_source_tree(newpath, cb);
-					free(newpath);
-				}
+					print_source_tree(buffer, cb);
 			}
 		}
 	}
@@ -208,7 +240,7 @@ void print_source_tree(const char* path, void (*cb)(const char*, int))
 
 	/* Close the enclosing group */
 	strcpy(buffer, path);
-	if (buffer[strlen(buffer)-1] == '/')   /* Trim off trailing path separator */
+	if (strlen(buffer) > 0 && buffer[strlen(buffer)-1] == '/')   /* Trim off trailing path separator */
 		buffer[strlen(buffer)-1] = '\0';
 	cb(buffer, WST_CLOSEGROUP);
 }
@@ -17,12 +17,21 @@
 
 #define ALLOCT(T)   (T*)malloc(sizeof(T))
 
+/* Static buffers used while generating are private to each thread, so
+ * that packages can be written in parallel (see jobs.c) */
+#if defined(_MSC_VER)
+#define THREAD_LOCAL  __declspec(thread)
+#else
+#define THREAD_LOCAL  __thread
+#endif
+
 enum { WST_OPENGROUP, WST_CLOSEGROUP, WST_SOURCEFILE };
 
-extern char g_buffer[];
+extern THREAD_LOCAL char g_buffer[];
 
 int         endsWith(const char* haystack, const char* needle);
 void        generateUUID(char* uuid);
+void        generateNamedUUID(const char* name, char* uuid);
 int         is_cpp(const char* name);
 int         matches(const char* str0, const char* str1);
 void        print_list(const char** list, const char* prefix, const char* postfix, const char* infix, const char* (*func)(const char*));
@@ -21,8 +21,10 @@
 #include <stdarg.h>
 #include "premake.h"
 #include "vs.h"
+#include "platform.h"
 
 static int version;
+static THREAD_LOCAL char refpath[8192];
 
 #define S_TRUE  (version < VS2005 ? "TRUE" : "true")
 #define S_FALSE (version < VS2005 ? "FALSE" : "false")
@@ -120,9 +122,9 @@ static int* blocks[] =
  * Helpers to hide XML formatting style differences
  ***********************************************************************/
 
-static int indent = 0;
-static int opened = 0;
-static int attrib = 0;
+static THREAD_LOCAL int indent = 0;
+static THREAD_LOCAL int opened = 0;
+static THREAD_LOCAL int attrib = 0;
 
 static void tag_indent()
 {
@@ -228,11 +230,20 @@ void vs_assign_guids()
 	int p;
 	for (p = 0; p < prj_get_numpackages(); ++p)
 	{
-		VsPkgData* data = ALLOCT(VsPkgData);
+		VsPkgData* data;
 		prj_select_package(p);
-		prj_set_data(data);
-	
-		generateUUID(data->projGuid);
+
+		/* A package's GUID comes from its location and name, so that it
+		 * stays the same from one run to the next. Packages that haven't
+		 * changed aren't rewritten, and must still match the solution */
+		data = (VsPkgData*)prj_get_data();
+		if (data == NULL)
+		{
+			data = ALLOCT(VsPkgData);
+			prj_set_data(data);
+			sprintf(g_buffer, "%s/%s/%s", prj_get_name(), prj_get_pkgpath(), prj_get_pkgname());
+			generateNamedUUID(g_buffer, data->projGuid);
+		}
 
 		prj_select_config(0);
 		if (version == VS2005 && prj_is_kind("aspnet"))
@@ -303,7 +314,7 @@ int vs_write_cpp()
 	if (version == VS2005)
 		tag_attr("RootNamespace=\"%s\"", prj_get_pkgname());
 
-	tag_attr("Keyword=\"%s\"", prj_has_flag("managed") ? "ManagedCProj" : "Win32Proj");  
+	tag_attr("Keyword=\"%s\"", prj_has_flag(FLAG_MANAGED) ? "ManagedCProj" : "Win32Proj");  
 
 	tag_open("Platforms");
 	tag_open("Platform");
@@ -348,34 +359,34 @@ int vs_write_cpp()
 			return 0;
 		}
 
-		if (prj_has_flag("optimize-speed"))
+		if (prj_has_flag(FLAG_OPTIMIZE_SPEED))
 			optimization = 2;
-		else if (prj_has_flag("optimize-size"))
+		else if (prj_has_flag(FLAG_OPTIMIZE_SIZE))
 			optimization = 1;
-		else if (prj_has_flag("optimize"))
+		else if (prj_has_flag(FLAG_OPTIMIZE))
 			optimization = 3;
 		else
 			optimization = 0;
 
 		debug = (optimization ==0);
 
-		if (prj_has_flag("static-runtime"))
+		if (prj_has_flag(FLAG_STATIC_RUNTIME))
 			runtime = (debug) ? 1 : 0;
 		else
 			runtime = (debug) ? 3 : 2;
 
-		if (prj_has_flag("no-symbols"))
+		if (prj_has_flag(FLAG_NO_SYMBOLS))
 			symbols = 0;
 		else
-			symbols = prj_has_flag("managed") ? 3 : 4;
+			symbols = prj_has_flag(FLAG_MANAGED) ? 3 : 4;
 
 		tag_open("Configuration");
 		tag_attr("Name=\"%s|Win32\"", prj_get_cfgname());
 		tag_attr("OutputDirectory=\"%s\"", prj_get_outdir());
 		tag_attr("IntermediateDirectory=\"%s\"", prj_get_objdir());
 		tag_attr("ConfigurationType=\"%d\"", configTypeId);
-		tag_attr("CharacterSet=\"%d\"", prj_has_flag("unicode") ? 1 : 2);
-		if (prj_has_flag("managed")) 
+		tag_attr("CharacterSet=\"%d\"", prj_has_flag(FLAG_UNICODE) ? 1 : 2);
+		if (prj_has_flag(FLAG_MANAGED)) 
 			tag_attr("ManagedExtensions=\"%s\"", S_TRUE);
 
 		/* Write out tool blocks */
@@ -456,7 +467,7 @@ int vs_write_cpp()
 
 				tag_attr("Optimization=\"%d\"", optimization);
 
-				if (prj_has_flag("no-frame-pointer")) 
+				if (prj_has_flag(FLAG_NO_FRAME_POINTER)) 
 					tag_attr("OmitFramePointers=\"%s\"", S_TRUE);
 
 				if (prj_get_numincpaths() > 0)
@@ -466,7 +477,7 @@ int vs_write_cpp()
 					tag_attr_close();
 				}
 
-				if (prj_has_flag("managed"))
+				if (prj_has_flag(FLAG_MANAGED))
 					tag_attr("AdditionalUsingDirectories=\"%s\"", prj_get_bindir());
 
 				if (prj_get_numdefines() > 0)
@@ -476,13 +487,13 @@ int vs_write_cpp()
 					tag_attr_close();
 				}
 
-				if (debug && !prj_has_flag("managed"))
+				if (debug && !prj_has_flag(FLAG_MANAGED))
 					tag_attr("MinimalRebuild=\"%s\"", S_TRUE);
 
-				if (prj_has_flag("no-exceptions")) 
+				if (prj_has_flag(FLAG_NO_EXCEPTIONS)) 
 					tag_attr("ExceptionHandling=\"%s\"", S_FALSE);
 
-				if (debug && !prj_has_flag("managed"))
+				if (debug && !prj_has_flag(FLAG_MANAGED))
 					tag_attr("BasicRuntimeChecks=\"3\"");
 				
 				if (!debug) 
@@ -491,17 +502,17 @@ int vs_write_cpp()
 				tag_attr("RuntimeLibrary=\"%d\"", runtime);
 				tag_attr("EnableFunctionLevelLinking=\"%s\"", S_TRUE);
 
-				if (version < VS2005 && !prj_has_flag("no-rtti"))
+				if (version < VS2005 && !prj_has_flag(FLAG_NO_RTTI))
 					tag_attr("RuntimeTypeInfo=\"%s\"", S_TRUE);
-				if (version == VS2005 && prj_has_flag("no-rtti"))
+				if (version == VS2005 && prj_has_flag(FLAG_NO_RTTI))
 					tag_attr("RuntimeTypeInfo=\"%s\"", S_FALSE);
 
 				tag_attr("UsePrecompiledHeader=\"%d\"", version < VS2005 ? 2 : 0);
-				tag_attr("WarningLevel=\"%d\"", prj_has_flag("extra-warnings") ? 4 : 3);
-				if (prj_has_flag("fatal-warnings"))
+				tag_attr("WarningLevel=\"%d\"", prj_has_flag(FLAG_EXTRA_WARNINGS) ? 4 : 3);
+				if (prj_has_flag(FLAG_FATAL_WARNINGS))
 					tag_attr("WarnAsError=\"%s\"", S_TRUE);
-				if (!prj_has_flag("managed")) 
-					tag_attr("Detect64BitPortabilityProblems=\"%s\"", prj_has_flag("no-64bit-checks") ? S_FALSE : S_TRUE);
+				if (!prj_has_flag(FLAG_MANAGED)) 
+					tag_attr("Detect64BitPortabilityProblems=\"%s\"", prj_has_flag(FLAG_NO_64BIT_CHECKS) ? S_FALSE : S_TRUE);
 
 				tag_attr("DebugInformationFormat=\"%d\"", symbols);
 				break;
@@ -509,7 +520,7 @@ int vs_write_cpp()
 				if (!prj_is_kind("lib"))
 				{
 					tag_attr("Name=\"VCLinkerTool\"");
-					if (prj_has_flag("no-import-lib"))
+					if (prj_has_flag(FLAG_NO_IMPORT_LIB))
 						tag_attr("IgnoreImportLibrary=\"%s\"", S_TRUE);
 
 					if (prj_get_numlinkoptions() > 0)
@@ -546,14 +557,14 @@ int vs_write_cpp()
 					if (!debug) tag_attr("OptimizeReferences=\"2\"");
 					if (!debug) tag_attr("EnableCOMDATFolding=\"2\"");
 
-					if ((prj_is_kind("exe") || prj_is_kind("winexe")) && !prj_has_flag("no-main"))
+					if ((prj_is_kind("exe") || prj_is_kind("winexe")) && !prj_has_flag(FLAG_NO_MAIN))
 					{
 						tag_attr("EntryPointSymbol=\"mainCRTStartup\"");
 					}
 					else if (prj_is_kind("dll")) 
 					{
 						tag_attr_open("ImportLibrary");
-						if (prj_has_flag("no-import-lib"))
+						if (prj_has_flag(FLAG_NO_IMPORT_LIB))
 							io_print(prj_get_objdir());
 						else
 							io_print(prj_get_libdir());
@@ -590,8 +601,7 @@ int vs_write_cpp()
 	tag_close("Globals", 1);
 	tag_close("VisualStudioProject", 1);
 
-	io_closefile();
-	return 1;
+	return io_closefile();
 }
 
 
@@ -675,27 +685,23 @@ void vs_list_files(const char* path, int stage)
 
 const char* vs_list_pkgdeps(const char* name)
 {
-	int i;
-	for (i = 0; i < prj_get_numpackages(); ++i)
+	VsPkgData* data;
+	int i = prj_find_package(name);
+	if (i < 0)
+		return NULL;
+
+	data = (VsPkgData*)prj_get_data_for(i);
+	if (version > VS2002)
 	{
-		if (matches(prj_get_pkgname_for(i), name))
-		{
-			VsPkgData* data = (VsPkgData*)prj_get_data_for(i);
-			if (version > VS2002)
-			{
-				sprintf(g_buffer, "{%s} = {%s}", data->projGuid, data->projGuid);
-			}
-			else
-			{
-				VsPkgData* src = (VsPkgData*)prj_get_data();
-				sprintf(g_buffer, "{%s}.%d = {%s}", src->projGuid, src->numDependencies, data->projGuid);
-				++(src->numDependencies);
-			}
-			return g_buffer;
-		}
+		sprintf(g_buffer, "{%s} = {%s}", data->projGuid, data->projGuid);
 	}
-
-	return NULL;
+	else
+	{
+		VsPkgData* src = (VsPkgData*)prj_get_data();
+		sprintf(g_buffer, "{%s}.%d = {%s}", src->projGuid, src->numDependencies, data->projGuid);
+		++(src->numDependencies);
+	}
+	return g_buffer;
 }
 
 
@@ -705,7 +711,17 @@ const char* vs_list_pkgdeps(const char* name)
 
 const char* vs_list_refpaths(const char* name)
 {
-	char* path = (char*)path_absolute(name);
-	path_translateInPlace(path, "windows");
-	return path;
+	char relative[8192];
+	const char* path;
+
+	/* Paths are relative to the package directory. The working directory
+	 * is shared by all threads, so it isn't changed to get there */
+	if (!platform_isAbsolutePath(name))
+		name = path_combine_r(prj_get_pkgpath(), name, relative);
+
+	path = path_absolute_r(name, refpath);
+	if (path != refpath)
+		strcpy(refpath, path);
+	path_translateInPlace(refpath, "windows");
+	return refpath;
 }
@@ -21,14 +21,14 @@
 #include "premake.h"
 #include "vs.h"
 #include "vs2002.h"
+#include "state.h"
 
+static int vs2002_write_package(int i);
 static int vs2002_write_solution();
 
 
 int vs2002_generate(int target)
 {
-	int i;
-
 	vs_setversion(target == 2002 ? VS2002 : VS2003);
 
 	printf("Generating Visual Studio %d solution and project files:\n", target);
@@ -37,29 +37,33 @@ int vs2002_generate(int target)
 	vs_assign_guids();
 
 	/* Generate the project files */
-	for (i = 0; i < prj_get_numpackages(); ++i)
-	{
-		prj_select_package(i);
+	if (!state_run(prj_get_numpackages(), vs2002_write_package))
+		return 0;
 
-		printf("...%s\n", prj_get_pkgname());
+	return vs2002_write_solution();
+}
 
-		if (prj_is_lang("c++") || prj_is_lang("c"))
-		{
-			if (!vs_write_cpp())
-				return 0;
-		}
-		else if (prj_is_lang("c#"))
-		{
-			if (!vs2002_cs())
-				return 0;
-		}
-		else
-		{
-			printf("** Warning: %s packages are not supported by this generator\n", prj_get_language());
-		}
-	}
 
-	return vs2002_write_solution();
+static int vs2002_write_package(int i)
+{
+	prj_select_package(i);
+	prj_select_config(0);
+
+	printf("...%s\n", prj_get_pkgname());
+
+	if (prj_is_lang("c++") || prj_is_lang("c"))
+	{
+		return vs_write_cpp();
+	}
+	else if (prj_is_lang("c#"))
+	{
+		return vs2002_cs();
+	}
+	else
+	{
+		printf("** Warning: %s packages are not supported by this generator\n", prj_get_language());
+		return 1;
+	}
 }
 
 
@@ -156,8 +160,7 @@ static int vs2002_write_solution()
 	io_print("\tEndGlobalSection\n");
 	io_print("EndGlobal\n");
 
-	io_closefile();
-	return 1;
+	return io_closefile();
 }
 
 
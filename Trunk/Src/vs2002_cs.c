@@ -103,11 +103,11 @@ int vs2002_cs()
 
 		prj_select_config(i);
 
-		optimize = prj_has_flag("optimize") || prj_has_flag("optimize-size") || prj_has_flag("optimize-speed");
+		optimize = prj_has_flag(FLAG_OPTIMIZE) || prj_has_flag(FLAG_OPTIMIZE_SIZE) || prj_has_flag(FLAG_OPTIMIZE_SPEED);
 
 		io_print("\t\t\t\t<Config\n");
 		io_print("\t\t\t\t\tName = \"%s\"\n", prj_get_cfgname());
-		io_print("\t\t\t\t\tAllowUnsafeBlocks = \"%s\"\n", prj_has_flag("unsafe") ? "true" : "false");
+		io_print("\t\t\t\t\tAllowUnsafeBlocks = \"%s\"\n", prj_has_flag(FLAG_UNSAFE) ? "true" : "false");
 		io_print("\t\t\t\t\tBaseAddress = \"285212672\"\n");
 		io_print("\t\t\t\t\tCheckForOverflowUnderflow = \"false\"\n");
 		io_print("\t\t\t\t\tConfigurationOverrideFile = \"\"\n");
@@ -117,7 +117,7 @@ int vs2002_cs()
 		io_print("\"\n");
 
 		io_print("\t\t\t\t\tDocumentationFile = \"\"\n");
-		io_print("\t\t\t\t\tDebugSymbols = \"%s\"\n", prj_has_flag("no-symbols") ? "false" : "true");
+		io_print("\t\t\t\t\tDebugSymbols = \"%s\"\n", prj_has_flag(FLAG_NO_SYMBOLS) ? "false" : "true");
 		io_print("\t\t\t\t\tFileAlignment = \"4096\"\n");
 		io_print("\t\t\t\t\tIncrementalBuild = \"false\"\n");
 		if (vs_getversion() == VS2003)
@@ -129,7 +129,7 @@ int vs2002_cs()
 		io_print("\t\t\t\t\tOutputPath = \"%s\"\n", prj_get_outdir());
 		io_print("\t\t\t\t\tRegisterForComInterop = \"false\"\n");
 		io_print("\t\t\t\t\tRemoveIntegerChecks = \"false\"\n");
-		io_print("\t\t\t\t\tTreatWarningsAsErrors = \"%s\"\n", prj_has_flag("fatal-warnings") ? "true" : "false");
+		io_print("\t\t\t\t\tTreatWarningsAsErrors = \"%s\"\n", prj_has_flag(FLAG_FATAL_WARNINGS) ? "true" : "false");
 		io_print("\t\t\t\t\tWarningLevel = \"4\"\n");  /* C# defaults to highest warning level */
 		io_print("\t\t\t\t/>\n");
 	}
@@ -151,7 +151,8 @@ int vs2002_cs()
 	io_print("\t</CSHARP>\n");
 	io_print("</VisualStudioProject>\n");
 
-	io_closefile();
+	if (!io_closefile())
+		return 0;
 
 	/* Now write the .csproj.user file for non-web applications or
 	 * .csproj.webinfo for web applications */
@@ -166,11 +167,8 @@ int vs2002_cs()
 		io_print("\t\t<Build>\n");
 		io_print("\t\t\t<Settings ReferencePath = \"");
 
-		strcpy(g_buffer, io_getcwd());
-		io_chdir(prj_get_pkgpath());
 		print_list(prj_get_libpaths(), "", ";", "", vs_list_refpaths);
 		io_print(vs_list_refpaths(prj_get_bindir()));
-		io_chdir(g_buffer);
 
 		io_print("\" >\n");
 
@@ -224,8 +222,7 @@ int vs2002_cs()
 		io_print("</VisualStudioUNCWeb>\n");
 	}
 
-	io_closefile();
-	return 1;
+	return io_closefile();
 }
 
 
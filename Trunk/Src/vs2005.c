@@ -21,14 +21,14 @@
 #include "premake.h"
 #include "vs.h"
 #include "vs2005.h"
+#include "state.h"
 
+static int vs2005_write_package(int p);
 static int vs2005_write_solution();
 static const char* list_aspnet_refs(const char* name);
 
 int vs2005_generate(int target)
 {
-	int p;
-
 	vs_setversion(VS2005);
 	printf("Generating Visual Studio 2005 solution and project files:\n");
 
@@ -36,34 +36,38 @@ int vs2005_generate(int target)
 	vs_assign_guids();
 
 	/* Generate the project files */
-	for (p = 0; p < prj_get_numpackages(); ++p)
-	{
-		prj_select_package(p);
-		prj_select_config(0);
+	if (!state_run(prj_get_numpackages(), vs2005_write_package))
+		return 0;
 
-		printf("...%s\n", prj_get_pkgname());
+	return vs2005_write_solution();
+}
 
-		if (prj_is_kind("aspnet"))
-		{
-			/* No project files?! */
-		}
-		else if (prj_is_lang("c++") || prj_is_lang("c"))
-		{
-			if (!vs_write_cpp())
-				return 0;
-		}
-		else if (prj_is_lang("c#"))
-		{
-			if (!vs2005_cs())
-				return 0;
-		}
-		else
-		{
-			printf("** Warning: %s packages are not supported by this generator\n", prj_get_language());
-		}
-	}
 
-	return vs2005_write_solution();
+static int vs2005_write_package(int p)
+{
+	prj_select_package(p);
+	prj_select_config(0);
+
+	printf("...%s\n", prj_get_pkgname());
+
+	if (prj_is_kind("aspnet"))
+	{
+		/* No project files?! */
+		return 1;
+	}
+	else if (prj_is_lang("c++") || prj_is_lang("c"))
+	{
+		return vs_write_cpp();
+	}
+	else if (prj_is_lang("c#"))
+	{
+		return vs2005_cs();
+	}
+	else
+	{
+		printf("** Warning: %s packages are not supported by this generator\n", prj_get_language());
+		return 1;
+	}
 }
 
 
@@ -114,7 +118,7 @@ static int vs2005_write_solution()
 				io_print("\t\t%s.AspNetCompiler.Updateable = \"true\"\n", prj_get_cfgname());
 				io_print("\t\t%s.AspNetCompiler.ForceOverwrite = \"true\"\n", prj_get_cfgname());
 				io_print("\t\t%s.AspNetCompiler.FixedNames = \"false\"\n", prj_get_cfgname());
-				io_print("\t\t%s.AspNetCompiler.Debug = \"%s\"\n", prj_get_cfgname(), prj_has_flag("no-symbols") ? "False" : "True");
+				io_print("\t\t%s.AspNetCompiler.Debug = \"%s\"\n", prj_get_cfgname(), prj_has_flag(FLAG_NO_SYMBOLS) ? "False" : "True");
 			}
 
 			if (numAspNet == 0)
@@ -219,8 +223,7 @@ static int vs2005_write_solution()
 	io_print("\tEndGlobalSection\n");
 	io_print("EndGlobal\n");
 
-	io_closefile();
-	return 1;
+	return io_closefile();
 }
 
 
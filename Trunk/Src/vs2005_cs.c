@@ -69,7 +69,7 @@ int vs2005_cs()
 
 		io_print("  <PropertyGroup Condition=\" '$(Configuration)|$(Platform)' == '%s|AnyCPU' \">\n", prj_get_cfgname());
 
-		if (!prj_has_flag("no-symbols"))
+		if (!prj_has_flag(FLAG_NO_SYMBOLS))
 		{
 			io_print("    <DebugSymbols>true</DebugSymbols>\n");
 			io_print("    <DebugType>full</DebugType>\n");
@@ -79,7 +79,7 @@ int vs2005_cs()
 			io_print("    <DebugType>pdbonly</DebugType>\n");
 		}
 
-		if (prj_has_flag("optimize") || prj_has_flag("optimize-size") || prj_has_flag("optimize-speed"))
+		if (prj_has_flag(FLAG_OPTIMIZE) || prj_has_flag(FLAG_OPTIMIZE_SIZE) || prj_has_flag(FLAG_OPTIMIZE_SPEED))
 			io_print("    <Optimize>true</Optimize>\n");
 		else
 			io_print("    <Optimize>false</Optimize>\n");
@@ -93,10 +93,10 @@ int vs2005_cs()
 		io_print("    <ErrorReport>prompt</ErrorReport>\n");
 		io_print("    <WarningLevel>4</WarningLevel>\n");
 
-		if (prj_has_flag("unsafe"))
+		if (prj_has_flag(FLAG_UNSAFE))
 			io_print("    <AllowUnsafeBlocks>true</AllowUnsafeBlocks>\n");
 
-		if (prj_has_flag("fatal-warnings"))
+		if (prj_has_flag(FLAG_FATAL_WARNINGS))
 			io_print("    <TreatWarningsAsErrors>true</TreatWarningsAsErrors>\n");
 
 		io_print("  </PropertyGroup>\n");
@@ -122,7 +122,8 @@ int vs2005_cs()
 	io_print("  -->\n");
 	io_print("</Project>\n");
 
-	io_closefile();
+	if (!io_closefile())
+		return 0;
 
 	/* Now write the .csproj.user file for non-web applications or
 	 * .csproj.webinfo for web applications */
@@ -135,11 +136,8 @@ int vs2005_cs()
 		io_print("  <PropertyGroup>\n");
 		io_print("    <ReferencePath>");
 
-		strcpy(g_buffer, io_getcwd());
-		io_chdir(prj_get_pkgpath());
 		print_list(prj_get_libpaths(), "", ";", "", vs_list_refpaths);
 		io_print(vs_list_refpaths(prj_get_bindir()));
-		io_chdir(g_buffer);
 
 		io_print("</ReferencePath>\n");
 		io_print("  </PropertyGroup>\n");
@@ -151,8 +149,7 @@ int vs2005_cs()
 			return 0;
 	}
 
-	io_closefile();
-	return 1;
+	return io_closefile();
 }
 
 
@@ -19,7 +19,9 @@
 #include <string.h>
 #include "premake.h"
 #include "vs6.h"
+#include "state.h"
 
+static int writePackage(int i);
 static int writeWorkspace();
 
 static const char* listPackageDeps(const char* name);
@@ -27,36 +29,39 @@ static const char* listPackageDeps(const char* name);
 
 int vs6_generate()
 {
-	int i;
-
 	puts("Generating Visual Studio 6 workspace and project files:");
 
-	for (i = 0; i < prj_get_numpackages(); ++i)
-	{
-		prj_select_package(i);
-
-		printf("...%s\n", prj_get_pkgname());
-
-		if (prj_is_lang("c++") || prj_is_lang("c"))
-		{
-			vs6_cpp();
-		}
-		else if (prj_is_lang("c#"))
-		{
-			puts("** Error: C# projects are not supported by Visual Studio 6");
-			return 0;
-		}
-		else
-		{
-			printf("** Error: unrecognized language '%s'\n", prj_get_language());
-			return 0;
-		}
-	}
+	if (!state_run(prj_get_numpackages(), writePackage))
+		return 0;
 
 	return writeWorkspace();
 }
 
 
+static int writePackage(int i)
+{
+	prj_select_package(i);
+
+	printf("...%s\n", prj_get_pkgname());
+
+	if (prj_is_lang("c++") || prj_is_lang("c"))
+	{
+		vs6_cpp();
+		return 1;
+	}
+	else if (prj_is_lang("c#"))
+	{
+		puts("** Error: C# projects are not supported by Visual Studio 6");
+		return 0;
+	}
+	else
+	{
+		printf("** Error: unrecognized language '%s'\n", prj_get_language());
+		return 0;
+	}
+}
+
+
 static int writeWorkspace()
 {
 	int i;
@@ -106,8 +111,7 @@ static int writeWorkspace()
 	io_print("###############################################################################\n");
 	io_print("\n");
 
-	io_closefile();
-	return 1;
+	return io_closefile();
 }
 
 
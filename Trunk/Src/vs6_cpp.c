@@ -108,8 +108,8 @@ int vs6_cpp()
 	{
 		const char* debugSymbol;
 
-		int optimizeSize  =  prj_has_flag("optimize-size");
-		int optimizeSpeed =  prj_has_flag("optimize-speed") || prj_has_flag("optimize");
+		int optimizeSize  =  prj_has_flag(FLAG_OPTIMIZE_SIZE);
+		int optimizeSpeed =  prj_has_flag(FLAG_OPTIMIZE_SPEED) || prj_has_flag(FLAG_OPTIMIZE);
 		int useDebugLibs  =  (!optimizeSize && !optimizeSpeed);
 
 		prj_select_config(i);
@@ -126,7 +126,7 @@ int vs6_cpp()
 		io_print("# PROP Use_Debug_Libraries %d\n", useDebugLibs ? 1 : 0);
 		io_print("# PROP Output_Dir \"%s\"\n", prj_get_outdir());
 		io_print("# PROP Intermediate_Dir \"%s\"\n", prj_get_objdir());
-		if (prj_is_kind("dll") && prj_has_flag("no-import-lib"))
+		if (prj_is_kind("dll") && prj_has_flag(FLAG_NO_IMPORT_LIB))
 			io_print("# PROP Ignore_Export_Lib 1\n");
 		io_print("# PROP Target_Dir \"\"\n");
 
@@ -135,7 +135,7 @@ int vs6_cpp()
 		io_print("# ADD CPP /nologo");
 		writeCppFlags();
 
-		debugSymbol = prj_has_flag("no-symbols") ? "NDEBUG" : "_DEBUG";
+		debugSymbol = prj_has_flag(FLAG_NO_SYMBOLS) ? "NDEBUG" : "_DEBUG";
 		if (prj_is_kind("winexe") || prj_is_kind("dll"))
 		{
 			io_print("# ADD BASE MTL /nologo /D \"%s\" /mktyplib203 /win32\n", debugSymbol);
@@ -182,8 +182,7 @@ int vs6_cpp()
 	io_print("# End Target\n");
 	io_print("# End Project\n");
 
-	io_closefile();
-	return 1;
+	return io_closefile();
 }
 
 
@@ -193,30 +192,30 @@ int vs6_cpp()
 
 static void writeCppFlags()
 {
-	int optimizeSize  =  prj_has_flag("optimize-size");
-	int optimizeSpeed =  prj_has_flag("optimize-speed") || prj_has_flag("optimize");
+	int optimizeSize  =  prj_has_flag(FLAG_OPTIMIZE_SIZE);
+	int optimizeSpeed =  prj_has_flag(FLAG_OPTIMIZE_SPEED) || prj_has_flag(FLAG_OPTIMIZE);
 	int useDebugLibs  =  (!optimizeSize && !optimizeSpeed);
 
 	if (useDebugLibs)
-		io_print(prj_has_flag("static-runtime") ? " /MTd" : " /MDd");
+		io_print(prj_has_flag(FLAG_STATIC_RUNTIME) ? " /MTd" : " /MDd");
 	else
-		io_print(prj_has_flag("static-runtime") ? " /MT" : " /MD");
+		io_print(prj_has_flag(FLAG_STATIC_RUNTIME) ? " /MT" : " /MD");
 	
-	io_print(" /W%d", prj_has_flag("extra-warnings") ? 4 : 3);
+	io_print(" /W%d", prj_has_flag(FLAG_EXTRA_WARNINGS) ? 4 : 3);
 	
-	if (prj_has_flag("fatal-warnings"))
+	if (prj_has_flag(FLAG_FATAL_WARNINGS))
 		io_print(" /WX");
 	
 	if (useDebugLibs)
 		io_print(" /Gm");  /* minimal rebuild */
 	
-	if (!prj_has_flag("no-rtti"))
+	if (!prj_has_flag(FLAG_NO_RTTI))
 		io_print(" /GR");
 	
-	if (!prj_has_flag("no-exceptions"))
+	if (!prj_has_flag(FLAG_NO_EXCEPTIONS))
 		io_print(" /GX");
 	
-	if (!prj_has_flag("no-symbols"))
+	if (!prj_has_flag(FLAG_NO_SYMBOLS))
 		io_print(" /ZI");  /* debug symbols for edit-and-continue */
 	
 	if (optimizeSize)
@@ -226,7 +225,7 @@ static void writeCppFlags()
 	else
 		io_print(" /Od");
 	
-	if (prj_has_flag("no-frame-pointer"))
+	if (prj_has_flag(FLAG_NO_FRAME_POINTER))
 		io_print(" /Oy");
 	
 	print_list(prj_get_incpaths(), " /I \"", "\"", "", NULL);
@@ -254,7 +253,7 @@ static void writeLinkFlags()
 	print_list(prj_get_links(), " ", ".lib", "", filterLinks);
 	io_print(" /nologo");
 
-	if ((prj_is_kind("winexe") || prj_is_kind("exe")) && !prj_has_flag("no-main"))
+	if ((prj_is_kind("winexe") || prj_is_kind("exe")) && !prj_has_flag(FLAG_NO_MAIN))
 		io_print(" /entry:\"mainCRTStartup\"");
 
 	if (prj_is_kind("winexe"))
@@ -264,7 +263,7 @@ static void writeLinkFlags()
 	else
 		io_print(" /dll");
 
-	if (!prj_has_flag("no-symbols"))
+	if (!prj_has_flag(FLAG_NO_SYMBOLS))
 		io_print(" /incremental:yes /debug");
 
 	io_print(" /machine:I386");
@@ -272,7 +271,7 @@ static void writeLinkFlags()
 	if (prj_is_kind("dll"))
 	{
 		io_print(" /implib:\"");
-		if (prj_has_flag("no-import-lib"))
+		if (prj_has_flag(FLAG_NO_IMPORT_LIB))
 			io_print(prj_get_objdir());
 		else
 			io_print(prj_get_libdir());
@@ -281,7 +280,7 @@ static void writeLinkFlags()
 
 	io_print(" /out:\"%s\"", prj_get_target());
 
-	if (!prj_has_flag("no-symbols"))
+	if (!prj_has_flag(FLAG_NO_SYMBOLS))
 		io_print(" /pdbtype:sept");
 
 	io_print(" /libpath:\"%s\"", prj_get_libdir());
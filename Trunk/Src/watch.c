@@ -0,0 +1,257 @@
+/**********************************************************************
+ * Premake - watch.c
+ * Watch the project's inputs for changes, for --watch.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "premake.h"
+#include "platform.h"
+#include "ignore.h"
+#include "match.h"
+#include "watch.h"
+
+/* How long things must stay quiet, in milliseconds, before a change is
+ * acted on. Lets a checkout or a build finish touching files first. */
+#define WATCH_DELAY   250
+
+typedef struct tagWatchDir
+{
+	char*  path;
+	char** masks;
+	int    numMasks;
+	char** scripts;
+	int    numScripts;
+} WatchDir;
+
+static WatchDir** my_dirs = NULL;
+static int        my_numDirs = 0;
+static int        my_changed;
+
+/* The last generated file seen being written, and where */
+static char       my_written[8192];
+static int        my_writtenDir = -1;
+
+static WatchDir*  getDir(const char* path);
+static int        addName(char*** list, int* count, const char* name);
+static void       onChange(int id, const char* name, int isdir, int kind);
+
+
+int watch_open()
+{
+	return platform_watch_open();
+}
+
+
+/************************************************************************
+ * Forget what each directory is being watched for. Called before the
+ * scripts are run again, as they may now search for different files.
+ ***********************************************************************/
+
+void watch_reset()
+{
+	int i;
+	for (i = 0; i < my_numDirs; ++i)
+	{
+		WatchDir* dir = my_dirs[i];
+		if (dir == NULL)
+			continue;
+
+		while (dir->numMasks > 0)
+			free(dir->masks[--dir->numMasks]);
+		while (dir->numScripts > 0)
+			free(dir->scripts[--dir->numScripts]);
+	}
+}
+
+
+/************************************************************************
+ * Watch for changes to a script. Editors often save by replacing the
+ * file, so the directory is watched rather than the file itself.
+ ***********************************************************************/
+
+void watch_addscript(const char* path)
+{
+	char dirpath[8192];
+	WatchDir* dir;
+
+	strcpy(dirpath, path_getdir(path));
+	dir = getDir(dirpath);
+	if (dir != NULL)
+		addName(&dir->scripts, &dir->numScripts, path_getname(path));
+}
+
+
+/************************************************************************
+ * Watch a directory that was searched for files. Only new, removed, or
+ * renamed entries matter, and only those that the search could match.
+ ***********************************************************************/
+
+void watch_adddir(const char* path, const char** patterns, int count)
+{
+	WatchDir* dir;
+	int i;
+
+	dir = getDir(path_absolute(path));
+	if (dir == NULL)
+		return;
+
+	for (i = 0; i < count; ++i)
+	{
+		const char* mask = strrchr(patterns[i], '/');
+		mask = (mask != NULL) ? mask + 1 : patterns[i];
+		addName(&dir->masks, &dir->numMasks, mask);
+	}
+}
+
+
+/************************************************************************
+ * Block until a relevant change is seen, then wait for things to quiet
+ * down before returning. Returns zero if changes can't be watched.
+ ***********************************************************************/
+
+int watch_wait()
+{
+	my_changed = 0;
+	while (!my_changed)
+	{
+		if (platform_watch_read(-1, onChange) < 0)
+			return 0;
+	}
+
+	while (platform_watch_read(WATCH_DELAY, onChange) > 0)
+		;
+
+	return 1;
+}
+
+
+static void onChange(int id, const char* name, int isdir, int kind)
+{
+	WatchDir* dir;
+	int i;
+
+	/* Events were lost; assume the worst */
+	if (kind == WATCH_OVERFLOW)
+	{
+		my_changed = 1;
+		return;
+	}
+
+	if (id < 0 || id >= my_numDirs || my_dirs[id] == NULL)
+		return;
+	dir = my_dirs[id];
+
+	/* Generated files are written under a temporary name and then moved
+	 * over the old one. Neither is a change to the sources */
+	if (endsWith(name, IO_TEMP_SUFFIX))
+	{
+		strcpy(my_written, name);
+		my_written[strlen(name) - strlen(IO_TEMP_SUFFIX)] = '\0';
+		my_writtenDir = id;
+		return;
+	}
+
+	if (id == my_writtenDir && matches(name, my_written))
+	{
+		my_writtenDir = -1;
+		return;
+	}
+
+	for (i = 0; i < dir->numScripts; ++i)
+	{
+		if (matches(dir->scripts[i], name))
+			my_changed = 1;
+	}
+
+	if (dir->numMasks == 0)
+		return;
+
+	/* Edits to an ignore file can change what the search finds */
+	if (matches(name, IGNORE_FILE))
+	{
+		my_changed = 1;
+		return;
+	}
+
+	if (kind != WATCH_ENTRIES)
+		return;
+
+	/* The directory itself was removed or renamed, or a subdirectory
+	 * appeared that might hold matching files */
+	if (strlen(name) == 0 || isdir)
+	{
+		my_changed = 1;
+		return;
+	}
+
+	for (i = 0; i < dir->numMasks; ++i)
+	{
+		if (match_path(dir->masks[i], name))
+			my_changed = 1;
+	}
+}
+
+
+static WatchDir* getDir(const char* path)
+{
+	WatchDir* dir;
+	int id;
+
+	/* Adding a directory that is already watched returns the same id */
+	id = platform_watch_add(path);
+	if (id < 0)
+		return NULL;
+
+	if (id >= my_numDirs)
+	{
+		my_dirs = (WatchDir**)realloc(my_dirs, sizeof(WatchDir*) * (id + 1));
+		while (my_numDirs <= id)
+			my_dirs[my_numDirs++] = NULL;
+	}
+
+	dir = my_dirs[id];
+	if (dir == NULL)
+	{
+		dir = ALLOCT(WatchDir);
+		dir->path = (char*)malloc(strlen(path) + 1);
+		strcpy(dir->path, path);
+		dir->masks = NULL;
+		dir->numMasks = 0;
+		dir->scripts = NULL;
+		dir->numScripts = 0;
+		my_dirs[id] = dir;
+	}
+
+	return dir;
+}
+
+
+static int addName(char*** list, int* count, const char* name)
+{
+	int i;
+	for (i = 0; i < *count; ++i)
+	{
+		if (matches((*list)[i], name))
+			return 0;
+	}
+
+	*list = (char**)realloc(*list, sizeof(char*) * (*count + 1));
+	(*list)[*count] = (char*)malloc(strlen(name) + 1);
+	strcpy((*list)[*count], name);
+	(*count)++;
+	return 1;
+}
@@ -0,0 +1,22 @@
+/**********************************************************************
+ * Premake - watch.h
+ * Watch the project's inputs for changes, for --watch.
+ *
+ * Copyright (c) 2002-2006 Jason Perkins and the Premake project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License in the file LICENSE.txt for details.
+ **********************************************************************/
+
+int  watch_open();
+void watch_reset();
+void watch_addscript(const char* path);
+void watch_adddir(const char* dir, const char** patterns, int count);
+int  watch_wait();
@@ -0,0 +1,262 @@
+using System;
+using System.Collections;
+using System.Diagnostics;
+using System.IO;
+using System.Text.RegularExpressions;
+
+namespace Premake.Tests.Framework
+{
+	/* A temporary directory that Premake can be run in more than once,
+	 * for tests that look at what a run leaves behind for the next one */
+	public class Sandbox
+	{
+		private string _executable;
+		private string _root;
+		private Script _script;
+
+		public string Errors;
+		public string Output;
+
+		public Sandbox()
+		{
+			_executable = Directory.GetCurrentDirectory() + Path.DirectorySeparatorChar + "premake";
+			_root = Path.GetTempPath() + Guid.NewGuid().ToString() + Path.DirectorySeparatorChar;
+			Directory.CreateDirectory(_root);
+		}
+
+		public string Root
+		{
+			get { return _root; }
+		}
+
+		public void Close()
+		{
+			if (Directory.Exists(_root))
+				Directory.Delete(_root, true);
+		}
+
+		#region Files
+		public void AddFile(string filename)
+		{
+			WriteFile(filename, String.Empty);
+		}
+
+		public void WriteFile(string filename, string text)
+		{
+			string path = GetPath(filename);
+			string dirname = Path.GetDirectoryName(path);
+			if (!Directory.Exists(dirname))
+				Directory.CreateDirectory(dirname);
+
+			StreamWriter writer = new StreamWriter(path);
+			writer.Write(text);
+			writer.Close();
+		}
+
+		public void WriteScript(Script script)
+		{
+			_script = script;
+			script.WriteFile(GetPath("premake.lua"));
+		}
+
+		public string Read(string filename)
+		{
+			StreamReader reader = new StreamReader(GetPath(filename));
+			string text = reader.ReadToEnd();
+			reader.Close();
+			return text;
+		}
+
+		public byte[] ReadBytes(string filename)
+		{
+			FileStream stream = new FileStream(GetPath(filename), FileMode.Open, FileAccess.Read);
+			byte[] bytes = new byte[stream.Length];
+			stream.Read(bytes, 0, bytes.Length);
+			stream.Close();
+			return bytes;
+		}
+
+		public bool Exists(string filename)
+		{
+			return File.Exists(GetPath(filename));
+		}
+
+		public void Delete(string filename)
+		{
+			File.Delete(GetPath(filename));
+		}
+
+		public DateTime GetModified(string filename)
+		{
+			return File.GetLastWriteTime(GetPath(filename));
+		}
+
+		public void SetModified(string filename, DateTime time)
+		{
+			File.SetLastWriteTime(GetPath(filename), time);
+		}
+
+		public string GetPath(string filename)
+		{
+			return Path.Combine(_root, filename);
+		}
+
+		/* Every file below the root, relative to it */
+		public string[] GetFiles()
+		{
+			ArrayList files = new ArrayList();
+			AddFiles(files, _root);
+			files.Sort();
+			return (string[])files.ToArray(typeof(string));
+		}
+
+		private void AddFiles(ArrayList files, string dirname)
+		{
+			foreach (string path in Directory.GetFiles(dirname))
+				files.Add(path.Substring(_root.Length));
+			foreach (string path in Directory.GetDirectories(dirname))
+				AddFiles(files, path);
+		}
+
+		/* Copy every file into another sandbox, so that it starts from the same inputs */
+		public void CopyTo(Sandbox other)
+		{
+			foreach (string filename in GetFiles())
+			{
+				string path = other.GetPath(filename);
+				string dirname = Path.GetDirectoryName(path);
+				if (!Directory.Exists(dirname))
+					Directory.CreateDirectory(dirname);
+				File.Copy(GetPath(filename), path, true);
+			}
+			other._script = _script;
+		}
+
+		/* Both sandboxes must hold the same files, byte for byte */
+		public void CompareTo(Sandbox other, params string[] ignore)
+		{
+			ArrayList skip = new ArrayList(ignore);
+			string[] mine = GetFiles();
+			string[] theirs = other.GetFiles();
+
+			foreach (string filename in theirs)
+			{
+				if (!skip.Contains(filename) && !File.Exists(GetPath(filename)))
+					throw new FormatException("Did not expect file '" + filename + "'");
+			}
+
+			foreach (string filename in mine)
+			{
+				if (skip.Contains(filename))
+					continue;
+				if (!other.Exists(filename))
+					throw new FormatException("Expected file '" + filename + "'");
+
+				byte[] expected = ReadBytes(filename);
+				byte[] actual = other.ReadBytes(filename);
+				bool same = (expected.Length == actual.Length);
+				for (int i = 0; same && i < expected.Length; ++i)
+					same = (expected[i] == actual[i]);
+				if (!same)
+					throw new FormatException("File '" + filename + "' is different");
+			}
+		}
+		#endregion
+
+		#region Running Premake
+		/* Run Premake in the sandbox; returns its exit code */
+		public int Run(string args)
+		{
+			Process process = Start(args);
+			Output = process.StandardOutput.ReadToEnd();
+			Errors = process.StandardError.ReadToEnd();
+			process.WaitForExit();
+			return process.ExitCode;
+		}
+
+		/* Run Premake and fail if it does */
+		public void RunOrFail(string args)
+		{
+			int code = Run(args);
+			if (code != 0)
+			{
+				string message = (Errors != String.Empty) ? Errors : Output;
+				throw new InvalidOperationException("Premake aborted with code " + code + ": \n" + message);
+			}
+		}
+
+		/* Run Premake with --watch until it has settled in to wait for changes */
+		public void RunUntilWatching(string args)
+		{
+			StopWatching(StartWatching(args));
+		}
+
+		/* Start Premake with --watch, returning once it is waiting for changes */
+		public Process StartWatching(string args)
+		{
+			Process process = Start("--watch " + args);
+			Output = String.Empty;
+
+			string line;
+			while ((line = process.StandardOutput.ReadLine()) != null)
+			{
+				Output += line + "\n";
+				if (line.StartsWith("Watching for changes"))
+					break;
+			}
+
+			if (line == null)
+			{
+				process.WaitForExit();
+				throw new InvalidOperationException("Premake stopped before watching: \n" + Output);
+			}
+			return process;
+		}
+
+		public void StopWatching(Process process)
+		{
+			if (!process.HasExited)
+				process.Kill();
+			process.WaitForExit();
+		}
+
+		private Process Start(string args)
+		{
+			Process process = new Process();
+			process.StartInfo.FileName = _executable;
+			process.StartInfo.Arguments = args;
+			process.StartInfo.CreateNoWindow = true;
+			process.StartInfo.WorkingDirectory = _root;
+			process.StartInfo.RedirectStandardOutput = true;
+			process.StartInfo.RedirectStandardError = true;
+			process.StartInfo.UseShellExecute = false;
+			process.Start();
+			return process;
+		}
+
+		/* Parse the files a target wrote and compare them to what is expected */
+		public void Parse(Parser parser, Project expected)
+		{
+			Project actual = new Project();
+
+			MatchCollection matches = Regex.Matches(_script.ToString(), "project.name = '(.+)'");
+			actual.Name = matches[0].Groups[1].ToString();
+
+			matches = Regex.Matches(_script.ToString(), "project.path = '(.+)'");
+			actual.Path = (matches.Count > 0) ? matches[0].Groups[1].ToString() : "";
+
+			string cwd = Directory.GetCurrentDirectory();
+			Directory.SetCurrentDirectory(_root);
+			try
+			{
+				parser.Parse(actual, Path.Combine(actual.Path, actual.Name));
+			}
+			finally
+			{
+				Directory.SetCurrentDirectory(cwd);
+			}
+			expected.CompareTo(actual);
+		}
+		#endregion
+	}
+}
@@ -150,5 +150,23 @@ namespace Premake.Tests.Gnu.Cpp
 			_expects.Package[0].Config[1].BuildFlags = new string[] { "optimize-speed", "no-symbols" };
 			Run();
 		}
+
+		[Test]
+		public void Test_ManyFlags()
+		{
+			_script.Append("package.buildflags = { 'extra-warnings', 'fatal-warnings', 'no-exceptions', 'no-frame-pointer', 'no-rtti' }");
+			_expects.Package[0].Config[0].BuildFlags = new string[] { "extra-warnings", "fatal-warnings", "no-exceptions", "no-frame-pointer", "no-rtti" };
+			_expects.Package[0].Config[1].BuildFlags = new string[] { "extra-warnings", "fatal-warnings", "no-exceptions", "no-frame-pointer", "no-rtti", "optimize", "no-symbols" };
+			Run();
+		}
+
+		[Test]
+		public void Test_UnknownFlag()
+		{
+			_script.Append("package.buildflags = { 'no-such-flag', 'no-rtti' }");
+			_expects.Package[0].Config[0].BuildFlags = new string[] { "no-rtti" };
+			_expects.Package[0].Config[1].BuildFlags = new string[] { "no-rtti", "optimize", "no-symbols" };
+			Run();
+		}
 	}
 }
@@ -67,5 +67,28 @@ namespace Premake.Tests.Gnu.Cpp
 			_expects.Package[0].Config[1].Defines = new string[] { "TRACE", "NDEBUG" };
 			Run();
 		}
+
+		[Test]
+		public void Test_ManyDefines()
+		{
+			string[] debug = new string[201];
+			string[] release = new string[201];
+			string text = "package.defines = { ";
+			for (int i = 0; i < 200; ++i)
+			{
+				text += "'DEFINE" + i + "', ";
+				debug[i] = "DEFINE" + i;
+				release[i] = "DEFINE" + i;
+			}
+			debug[200] = "DEBUG";
+			release[200] = "NDEBUG";
+
+			_script.Append(text + "}");
+			_script.Append("package.config['Debug'].defines = { 'DEBUG' }");
+			_script.Append("package.config['Release'].defines = { 'NDEBUG' }");
+			_expects.Package[0].Config[0].Defines = debug;
+			_expects.Package[0].Config[1].Defines = release;
+			Run();
+		}
 	}
 }
@@ -101,6 +101,27 @@ namespace Premake.Tests.Gnu.Cpp
 			Run("--os linux");
 		}
 
+		[Test]
+		public void Test_ExeAndDllWithConfigTarget()
+		{
+			/* Each configuration links to the matching configuration's target */
+			_script.Append("package.links = { 'PackageB' }");
+			_script.Append("package = newpackage()");
+			_script.Append("package.name = 'PackageB'");
+			_script.Append("package.kind = 'dll'");
+			_script.Append("package.language = 'c++'");
+			_script.Append("package.files = matchfiles('*.cpp')");
+			_script.Append("package.config['Debug'].target = 'PackageB-d'");
+
+			_expects.Package[0].Config[0].Dependencies = new string[]{ "PackageB" };
+			_expects.Package[0].Config[1].Dependencies = new string[]{ "PackageB" };
+
+			_expects.Package[0].Config[0].LinkDeps = new string[]{ "libPackageB-d.so" };
+			_expects.Package[0].Config[1].LinkDeps = new string[]{ "libPackageB.so" };
+
+			Run("--os linux");
+		}
+
 		#endregion
 
 		#region Static Lib Dependencies
@@ -174,7 +195,56 @@ namespace Premake.Tests.Gnu.Cpp
 			Run("--os linux");
 		}
 
+		[Test]
+		public void Test_ExeAndLibWithConfigDirs()
+		{
+			/* Paths are worked out per configuration, relative to the linking package */
+			_script.Append("project.config['Debug'].libdir = 'lib/Debug'");
+			_script.Append("project.config['Release'].libdir = 'lib/Release'");
+
+			_script.Append("package.path = 'MyPackage'");
+			_script.Append("package.links = { 'PackageB' }");
+
+			_script.Append("package = newpackage()");
+			_script.Append("package.name = 'PackageB'");
+			_script.Append("package.kind = 'lib'");
+			_script.Append("package.language = 'c++'");
+			_script.Append("package.files = matchfiles('*.cpp')");
+			_script.Append("package.path = 'Libs/PackageB'");
+
+			_expects.Package[0].Config[0].Dependencies = new string[]{ "PackageB" };
+			_expects.Package[0].Config[1].Dependencies = new string[]{ "PackageB" };
+
+			_expects.Package[0].Config[0].LinkDeps = new string[]{ "../lib/Debug/libPackageB.a" };
+			_expects.Package[0].Config[1].LinkDeps = new string[]{ "../lib/Release/libPackageB.a" };
+
+			Run("--os linux");
+		}
+
 		#endregion
 
+
+		[Test]
+		public void Test_SiblingAndSystemLinks()
+		{
+			/* Only names that match a package exactly are dependencies */
+			_script.Append("package.links = { 'm', 'PackageB', 'packageb' }");
+			_script.Append("package = newpackage()");
+			_script.Append("package.name = 'PackageB'");
+			_script.Append("package.kind = 'dll'");
+			_script.Append("package.language = 'c++'");
+			_script.Append("package.files = matchfiles('*.cpp')");
+
+			_expects.Package[0].Config[0].Dependencies = new string[]{ "PackageB" };
+			_expects.Package[0].Config[1].Dependencies = new string[]{ "PackageB" };
+
+			_expects.Package[0].Config[0].Links = new string[]{ "m", "packageb" };
+			_expects.Package[0].Config[1].Links = new string[]{ "m", "packageb" };
+
+			_expects.Package[0].Config[0].LinkDeps = new string[]{ "libPackageB.so" };
+			_expects.Package[0].Config[1].LinkDeps = new string[]{ "libPackageB.so" };
+
+			Run("--os linux");
+		}
 	}
 }
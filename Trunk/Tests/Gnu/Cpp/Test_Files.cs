@@ -56,5 +56,15 @@ namespace Premake.Tests.Gnu.Cpp
 			_expects.Package[0].File.Add("../Help/file2.cpp");
 			Run();
 		}
+
+		[Test]
+		public void Test_FilesPerConfig()
+		{
+			_script.Replace("'somefile.txt'", "'file1.cpp'");
+			_script.Append("package.config['Release'].files = { 'file2.cpp' }");
+			_expects.Package[0].File.Add("file1.cpp");
+			_expects.Package[0].File.Add("file2.cpp");
+			Run();
+		}
 	}
 }
@@ -108,5 +108,18 @@ namespace Premake.Tests.Gnu.Cs
 			Run();
 		}
 
+		[Test]
+		public void Test_ActionsByFullPath()
+		{
+			/* Files with the same name in different directories keep their own actions */
+			_script.Replace("'somefile.txt'", "'a/file0.cs','b/file0.cs','a/file1.txt','b/file1.txt'");
+			_script.Append("package.config['b/file0.cs'].buildaction = 'Content'");
+			_script.Append("package.config['a/file1.txt'].buildaction = 'EmbeddedResource'");
+			_expects.Package[0].File.Add("a/file0.cs", "Compile");
+			_expects.Package[0].File.Add("b/file0.cs", "Content");
+			_expects.Package[0].File.Add("a/file1.txt", "EmbeddedResource");
+			Run();
+		}
+
 	}
 }
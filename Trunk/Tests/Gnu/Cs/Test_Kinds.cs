@@ -65,5 +65,25 @@ namespace Premake.Tests.Gnu.Cs
 			_expects.Package[0].Config[1].Kind = "dll";
 			Run();
 		}
+
+		[Test]
+		public void Test_KindOfEachPackage()
+		{
+			/* Each package is described by its own kind, not the last one written */
+			_script.Replace("exe", "dll");
+			_script.Append("package = newpackage()");
+			_script.Append("package.name = 'PackageB'");
+			_script.Append("package.kind = 'exe'");
+			_script.Append("package.language = 'c#'");
+			_script.Append("package.files = { 'somefile.txt' }");
+
+			_expects.Package.Add(1);
+			_expects.Package[1].Config.Add(2);
+			_expects.Package[0].Config[0].Kind = "dll";
+			_expects.Package[0].Config[1].Kind = "dll";
+			_expects.Package[1].Config[0].Kind = "exe";
+			_expects.Package[1].Config[1].Kind = "exe";
+			Run();
+		}
 	}
 }
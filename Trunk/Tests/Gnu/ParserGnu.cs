@@ -281,27 +281,16 @@ namespace Premake.Tests.Gnu
 				else
 					Match("  BLDCMD = $(CC) -o $(OUTDIR)/$(TARGET) $(OBJECTS) $(LDFLAGS) $(RESOURCES)");
 
+				/* Configurations that build different files list them here */
+				ParseFileLists("  ");
+
 				Match("endif");
 				Match("");
 
 				config.BuildFlags = (string[])buildFlags.ToArray(typeof(string));
 			}
 
-			Match("OBJECTS := \\");
-			do
-			{
-				matches = Regex("\t\\$\\(OBJDIR\\)/(.+?) \\\\", true);
-			} while (matches != null);
-			Match("");
-
-			if (Match("RESOURCES := \\", true))
-			{
-				do
-				{
-					matches = Regex("\t\\$\\(OBJDIR\\)/(.+?) \\\\", true);
-				} while (matches != null);
-				Match("");
-			}
+			ParseFileLists("");
 
 			Match("CMD := $(subst \\,\\\\,$(ComSpec)$(COMSPEC))");
 			Match("ifeq (,$(CMD))");
@@ -393,6 +382,29 @@ namespace Premake.Tests.Gnu
 
 			Match("-include $(OBJECTS:%.o=%.d)");
 		}
+
+		private void ParseFileLists(string indent)
+		{
+			string[] matches;
+
+			if (Match(indent + "OBJECTS := \\", true))
+			{
+				do
+				{
+					matches = Regex("\t\\$\\(OBJDIR\\)/(.+?) \\\\", true);
+				} while (matches != null);
+				Match("");
+			}
+
+			if (Match(indent + "RESOURCES := \\", true))
+			{
+				do
+				{
+					matches = Regex("\t\\$\\(OBJDIR\\)/(.+?) \\\\", true);
+				} while (matches != null);
+				Match("");
+			}
+		}
 		#endregion
 
 		#region Managed Code Parsing
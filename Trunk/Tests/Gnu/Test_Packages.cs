@@ -1,4 +1,7 @@
 using System;
+using System.Collections;
+using System.IO;
+using System.Text.RegularExpressions;
 using NUnit.Framework;
 using Premake.Tests.Framework;
 
@@ -27,6 +30,22 @@ namespace Premake.Tests.Gnu
 		{
 			TestEnvironment.Run(_script, _parser, _expects, null);
 		}
+
+		public void AddPackage(string name, string kind, string lang)
+		{
+			_script.Append("package = newpackage()");
+			_script.Append("package.name = '" + name + "'");
+			_script.Append("package.kind = '" + kind + "'");
+			_script.Append("package.language = '" + lang + "'");
+			_script.Append("package.files = { 'somefile.txt' }");
+		}
+
+		/* The command the makefile runs to regenerate itself */
+		public string RegenerateRule(Sandbox sandbox)
+		{
+			Match match = Regex.Match(sandbox.Read("Makefile"), "\t@premake (.*)\n");
+			return match.Groups[1].ToString();
+		}
 		#endregion
 
 		[Test]
@@ -59,5 +78,526 @@ namespace Premake.Tests.Gnu
 			Run();
 		}
 
+		[Test]
+		public void Test_Jobs()
+		{
+			/* Packages written on several threads come out as they do one at a time */
+			AddPackage("PackageB", "dll", "c#");
+			AddPackage("PackageC", "lib", "c++");
+			AddPackage("PackageD", "winexe", "c#");
+			AddPackage("PackageE", "dll", "c");
+
+			Sandbox serial = new Sandbox();
+			Sandbox parallel = new Sandbox();
+			try
+			{
+				serial.WriteScript(_script);
+				serial.CopyTo(parallel);
+				serial.RunOrFail("--target gnu");
+				parallel.RunOrFail("--jobs 4 --target gnu");
+				serial.CompareTo(parallel);
+			}
+			finally
+			{
+				serial.Close();
+				parallel.Close();
+			}
+		}
+
+		[Test]
+		public void Test_JobsKeepPackagesApart()
+		{
+			/* Each package written on its own thread sees only its own settings */
+			for (int i = 0; i < 16; ++i)
+			{
+				AddPackage("Pkg" + i, (i % 2 == 0) ? "lib" : "dll", "c++");
+				_script.Append("package.defines = { 'PKG" + i + "' }");
+				_script.Append("package.target = 'Out" + i + "'");
+			}
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--os linux --jobs 8 --target gnu");
+				for (int i = 0; i < 16; ++i)
+				{
+					string name = "Pkg" + i;
+					string text = sandbox.Read(name + ".make");
+					Assert.AreEqual(2, Regex.Matches(text, "-D \"PKG").Count, name);
+					Assert.AreEqual(2, Regex.Matches(text, "-D \"PKG" + i + "\"").Count, name);
+					Assert.AreEqual(2, Regex.Matches(text, "TARGET := libOut" + i + "\\.").Count, name);
+				}
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_MultipleTargets()
+		{
+			_expects.Package[0].Name = "MyPackage";
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--target vs2005,gnu");
+				sandbox.Parse(_parser, _expects);
+				sandbox.Parse(new Premake.Tests.Vs2005.Vs2005Parser(), _expects);
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_MultipleTargetsAfterOne()
+		{
+			/* What was recorded for the first target doesn't skip the second */
+			_expects.Package[0].Name = "MyPackage";
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--target gnu");
+				Assert.IsFalse(sandbox.Exists("MyPackage.vcproj"));
+
+				sandbox.RunOrFail("--target gnu,vs2005");
+				Assert.IsTrue(sandbox.Exists("MyProject.sln"), "Solution was not written");
+				Assert.IsTrue(sandbox.Exists("MyPackage.vcproj"), "Project was not written");
+				sandbox.Parse(_parser, _expects);
+				sandbox.Parse(new Premake.Tests.Vs2005.Vs2005Parser(), _expects);
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_SaveModel()
+		{
+			_expects.Package[0].Name = "MyPackage";
+			TestEnvironment.Run(_script, _parser, _expects, new string[] { "--save-model", "premake.model" });
+		}
+
+		public void RoundTrip(string target, string lang)
+		{
+			/* A saved model generates what the script it came from does. The
+			 * VS targets write absolute paths, so both runs use the same place */
+			AddPackage("PackageB", "dll", lang);
+
+			Sandbox sandbox = new Sandbox();
+			Sandbox fromScript = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--save-model premake.model --target " + target);
+				sandbox.CopyTo(fromScript);
+
+				foreach (string filename in sandbox.GetFiles())
+				{
+					if (filename != "premake.lua" && filename != "premake.model")
+						sandbox.Delete(filename);
+				}
+
+				sandbox.RunOrFail("--from-model premake.model --target " + target);
+				fromScript.CompareTo(sandbox);
+			}
+			finally
+			{
+				sandbox.Close();
+				fromScript.Close();
+			}
+		}
+
+		[Test]
+		public void Test_SaveModelRoundTripGnu()
+		{
+			RoundTrip("gnu", "c#");
+		}
+
+		[Test]
+		public void Test_SaveModelRoundTripVs6()
+		{
+			RoundTrip("vs6", "c");
+		}
+
+		[Test]
+		public void Test_SaveModelRoundTripVs2003()
+		{
+			RoundTrip("vs2003", "c#");
+		}
+
+		[Test]
+		public void Test_SaveModelRoundTripVs2005()
+		{
+			RoundTrip("vs2005", "c#");
+		}
+
+		[Test]
+		public void Test_SaveModelRejectsDamage()
+		{
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--save-model premake.model --target gnu");
+				byte[] model = sandbox.ReadBytes("premake.model");
+
+				/* Cut short */
+				FileStream stream = new FileStream(sandbox.GetPath("short.model"), FileMode.Create);
+				stream.Write(model, 0, model.Length / 2);
+				stream.Close();
+				Assert.AreNotEqual(0, sandbox.Run("--from-model short.model --target gnu"), "Loaded a truncated model");
+
+				/* Not a model at all */
+				model[0] ^= 0xFF;
+				stream = new FileStream(sandbox.GetPath("bad.model"), FileMode.Create);
+				stream.Write(model, 0, model.Length);
+				stream.Close();
+				Assert.AreNotEqual(0, sandbox.Run("--from-model bad.model --target gnu"), "Loaded a corrupt model");
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_UnchangedPackage()
+		{
+			/* The second run finds the packages unchanged and leaves them be */
+			AddPackage("PackageB", "exe", "c++");
+			DateTime stamp = new DateTime(2001, 1, 1);
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--target gnu");
+				string mine = sandbox.Read("MyPackage.make");
+				string theirs = sandbox.Read("PackageB.make");
+				sandbox.SetModified("MyPackage.make", stamp);
+				sandbox.SetModified("PackageB.make", stamp);
+
+				sandbox.RunOrFail("--target gnu");
+				Assert.IsTrue(sandbox.Output.IndexOf("0 of 2 packages regenerated") >= 0, sandbox.Output);
+				Assert.AreEqual(stamp, sandbox.GetModified("MyPackage.make"));
+				Assert.AreEqual(stamp, sandbox.GetModified("PackageB.make"));
+				Assert.AreEqual(mine, sandbox.Read("MyPackage.make"));
+				Assert.AreEqual(theirs, sandbox.Read("PackageB.make"));
+
+				/* Changing one package only writes that one again */
+				_script.Append("package.defines = { 'CHANGED' }");
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--target gnu");
+				Assert.IsTrue(sandbox.Output.IndexOf("1 of 2 packages regenerated") >= 0, sandbox.Output);
+				Assert.AreEqual(stamp, sandbox.GetModified("MyPackage.make"));
+				Assert.AreNotEqual(stamp, sandbox.GetModified("PackageB.make"));
+				Assert.IsTrue(sandbox.Read("PackageB.make").IndexOf("-D \"CHANGED\"") >= 0, "PackageB was not written again");
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_UnchangedPackageInMovedTree()
+		{
+			/* Where the tree is doesn't matter, only what is in it */
+			AddPackage("PackageB", "exe", "c++");
+
+			Sandbox sandbox = new Sandbox();
+			Sandbox moved = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--target gnu");
+				sandbox.CopyTo(moved);
+
+				moved.RunOrFail("--target gnu");
+				Assert.IsTrue(moved.Output.IndexOf("0 of 2 packages regenerated") >= 0, moved.Output);
+			}
+			finally
+			{
+				sandbox.Close();
+				moved.Close();
+			}
+		}
+
+		[Test]
+		public void Test_UnchangedPackagesWithSameName()
+		{
+			/* Packages are told apart by where they are as well as their names */
+			_script.Append("package.path = 'a'");
+			AddPackage("MyPackage", "exe", "c++");
+			_script.Append("package.path = 'b'");
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--target gnu");
+
+				_script.Append("package.defines = { 'CHANGED' }");
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--target gnu");
+				Assert.IsTrue(sandbox.Output.IndexOf("1 of 2 packages regenerated") >= 0, sandbox.Output);
+				Assert.IsTrue(sandbox.Read("b/Makefile").IndexOf("CHANGED") >= 0, "Package in b was not written again");
+				Assert.IsTrue(sandbox.Read("a/Makefile").IndexOf("CHANGED") < 0, "Package in a was changed");
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		/* Generating the same files again leaves them as they were on disk */
+		public void UnchangedFiles(string target)
+		{
+			AddPackage("PackageB", "dll", "c++");
+			DateTime stamp = new DateTime(2001, 1, 1);
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--verbose --target " + target);
+
+				ArrayList files = new ArrayList();
+				foreach (string filename in sandbox.GetFiles())
+				{
+					if (filename != "premake.lua" && filename != ".premake.state")
+					{
+						files.Add(filename);
+						sandbox.SetModified(filename, stamp);
+					}
+				}
+
+				/* Without the state every file is generated again */
+				sandbox.Delete(".premake.state");
+				sandbox.RunOrFail("--verbose --target " + target);
+				foreach (string filename in files)
+				{
+					Assert.AreEqual(stamp, sandbox.GetModified(filename), filename + " was written again");
+					Assert.IsTrue(sandbox.Output.IndexOf("Unchanged " + filename) >= 0, sandbox.Output);
+				}
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_UnchangedFilesGnu()
+		{
+			UnchangedFiles("gnu");
+		}
+
+		[Test]
+		public void Test_UnchangedFilesVs2005()
+		{
+			UnchangedFiles("vs2005");
+		}
+
+
+		[Test]
+		public void Test_ManyPackageLinks()
+		{
+			/* Enough packages that every link must be found by name */
+			_script.Append("package.links = { 'Pkg39', 'm' }");
+			for (int i = 0; i < 40; ++i)
+			{
+				AddPackage("Pkg" + i, "dll", "c++");
+				if (i > 0)
+					_script.Append("package.links = { 'm', 'Pkg" + (i - 1) + "' }");
+			}
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--os linux --target gnu");
+
+				string makefile = sandbox.Read("Makefile");
+				Assert.IsTrue(makefile.IndexOf("\nMyPackage: Pkg39\n") >= 0, "MyPackage");
+				Assert.IsTrue(makefile.IndexOf("\nPkg0:\n") >= 0, "Pkg0");
+				for (int i = 1; i < 40; ++i)
+				{
+					string name = "Pkg" + i;
+					Assert.IsTrue(makefile.IndexOf("\n" + name + ": Pkg" + (i - 1) + "\n") >= 0, name);
+					Assert.IsTrue(sandbox.Read(name + ".make").IndexOf("LDDEPS := libPkg" + (i - 1) + ".so\n") >= 0, name);
+				}
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_NoTemporaryFilesLeft()
+		{
+			/* Files are written under another name and moved into place */
+			AddPackage("PackageB", "exe", "c++");
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--target gnu");
+
+				_script.Append("package.defines = { 'CHANGED' }");
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--target gnu");
+
+				string[] files = sandbox.GetFiles();
+				Assert.AreEqual(5, files.Length, String.Join(" ", files));
+				Assert.AreEqual(".premake.state", files[0]);
+				Assert.AreEqual("Makefile", files[1]);
+				Assert.AreEqual("MyPackage.make", files[2]);
+				Assert.AreEqual("PackageB.make", files[3]);
+				Assert.AreEqual("premake.lua", files[4]);
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_FailedWriteLeavesNoTemporaryFile()
+		{
+			/* A file that can't be moved into place fails the run and is cleaned up */
+			AddPackage("PackageB", "exe", "c++");
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				Directory.CreateDirectory(sandbox.GetPath("PackageB.make"));
+				Assert.AreNotEqual(0, sandbox.Run("--target gnu"));
+
+				string[] files = sandbox.GetFiles();
+				Assert.AreEqual(2, files.Length, String.Join(" ", files));
+				Assert.AreEqual("MyPackage.make", files[0]);
+				Assert.AreEqual("premake.lua", files[1]);
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_RegenerateWithoutThreads()
+		{
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--threads 4 --os linux --target gnu");
+				Assert.AreEqual("--file $^ --os linux --target gnu", RegenerateRule(sandbox));
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_RegenerateWithoutDirCache()
+		{
+			/* The cache belongs to the run that made it */
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--dircache dircache.txt --os linux --target gnu");
+				Assert.AreEqual("--file $^ --os linux --target gnu", RegenerateRule(sandbox));
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_RegenerateWithoutWatch()
+		{
+			/* make would never get control back */
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunUntilWatching("--os linux --target gnu");
+				Assert.AreEqual("--file $^ --os linux --target gnu", RegenerateRule(sandbox));
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_RegenerateWithoutGitIndex()
+		{
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--gitindex --include-untracked --os linux --target gnu");
+				Assert.AreEqual("--file $^ --os linux --target gnu", RegenerateRule(sandbox));
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_RegenerateWithoutJobs()
+		{
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--jobs 4 --os linux --target gnu");
+				Assert.AreEqual("--file $^ --os linux --target gnu", RegenerateRule(sandbox));
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_RegenerateWithoutModel()
+		{
+			/* Regenerating always reruns the script */
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.RunOrFail("--save-model model.bin --os linux --target gnu");
+				Assert.AreEqual("--file $^ --os linux --target gnu", RegenerateRule(sandbox));
+
+				sandbox.Delete("Makefile");
+				sandbox.RunOrFail("--from-model model.bin --os linux --target gnu");
+				Assert.AreEqual("--file $^ --os linux --target gnu", RegenerateRule(sandbox));
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
 	}
 }
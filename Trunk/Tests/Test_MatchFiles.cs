@@ -1,4 +1,7 @@
 using System;
+using System.Diagnostics;
+using System.IO;
+using System.Threading;
 using NUnit.Framework;
 using Premake.Tests.Framework;
 
@@ -120,5 +123,362 @@ namespace Premake.Tests
 			_expects.Package[0].File.Add("Sub0/Sub1/cccc.cpp");
 			Run();
 		}
+
+		[Test]
+		public void Test_DoubleStarPattern()
+		{
+			_script.Replace("'somefile.txt'", "matchfiles('Src/**/test_*.cpp')");
+			TestEnvironment.AddFile("test_aaaa.cpp");
+			TestEnvironment.AddFile("Src/test_bbbb.cpp");
+			TestEnvironment.AddFile("Src/Sub0/test_cccc.cpp");
+			TestEnvironment.AddFile("Src/Sub0/dddd.cpp");
+			_expects.Package[0].File.Add("Src/test_bbbb.cpp");
+			_expects.Package[0].File.Add("Src/Sub0/test_cccc.cpp");
+			Run();
+		}
+
+		[Test]
+		public void Test_RecursiveMatchWithMultipleMasks()
+		{
+			_script.Replace("'somefile.txt'", "matchrecursive('*.cpp', '*.h')");
+			TestEnvironment.AddFile("aaaa.cpp");
+			TestEnvironment.AddFile("aaaa.h");
+			TestEnvironment.AddFile("Sub0/bbbb.cpp");
+			TestEnvironment.AddFile("Sub0/bbbb.h");
+			_expects.Package[0].File.Add("aaaa.cpp");
+			_expects.Package[0].File.Add("aaaa.h");
+			_expects.Package[0].File.Add("Sub0/bbbb.cpp");
+			_expects.Package[0].File.Add("Sub0/bbbb.h");
+			Run();
+		}
+
+		[Test]
+		public void Test_OverlappingMasksAreNotDuplicated()
+		{
+			_script.Replace("'somefile.txt'", "matchfiles('*.cpp', 'aaaa*.cpp'), 'bbbb.cpp'");
+			TestEnvironment.AddFile("aaaa.cpp");
+			TestEnvironment.AddFile("bbbb.cpp");
+			_expects.Package[0].File.Add("aaaa.cpp");
+			_expects.Package[0].File.Add("bbbb.cpp");
+			Run();
+		}
+
+		[Test]
+		public void Test_RecursiveMatchSkipsVersionControlDirs()
+		{
+			_script.Replace("'somefile.txt'", "matchrecursive('*.cpp')");
+			TestEnvironment.AddFile("aaaa.cpp");
+			TestEnvironment.AddFile(".svn/bbbb.cpp");
+			TestEnvironment.AddFile("Sub0/.git/cccc.cpp");
+			TestEnvironment.AddFile("Sub0/CVS/dddd.cpp");
+			_expects.Package[0].File.Add("aaaa.cpp");
+			Run();
+		}
+
+		[Test]
+		public void Test_ExcludePatternInMatch()
+		{
+			_script.Replace("'somefile.txt'", "matchrecursive('*.cpp', '!*_test.cpp')");
+			TestEnvironment.AddFile("aaaa.cpp");
+			TestEnvironment.AddFile("aaaa_test.cpp");
+			TestEnvironment.AddFile("Sub0/bbbb.cpp");
+			TestEnvironment.AddFile("Sub0/bbbb_test.cpp");
+			_expects.Package[0].File.Add("aaaa.cpp");
+			_expects.Package[0].File.Add("Sub0/bbbb.cpp");
+			Run();
+		}
+
+		[Test]
+		public void Test_DirectoryNamedLikeFile()
+		{
+			/* Only files are matched, whatever a directory is called */
+			_script.Replace("'somefile.txt'", "matchrecursive('*.cpp')");
+			TestEnvironment.AddFile("aaaa.cpp");
+			TestEnvironment.AddFile("Sub0.cpp/bbbb.cpp");
+			_expects.Package[0].File.Add("aaaa.cpp");
+			_expects.Package[0].File.Add("Sub0.cpp/bbbb.cpp");
+			Run();
+		}
+
+		[Test]
+		public void Test_SymbolicLinks()
+		{
+			/* Links are followed to what they point at; broken ones are left out */
+			if (Path.DirectorySeparatorChar != '/')
+				return;
+
+			_script.Replace("'somefile.txt'", "matchrecursive('*.cpp')");
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.AddFile("Real/aaaa.cpp");
+				sandbox.AddFile("Sub0/bbbb.cpp");
+				Link(sandbox, "Real", "Linked");
+				Link(sandbox, "Sub0/bbbb.cpp", "cccc.cpp");
+				Link(sandbox, "missing.cpp", "dddd.cpp");
+
+				sandbox.RunOrFail("--target gnu");
+				_expects.Package[0].File.Add("Real/aaaa.cpp");
+				_expects.Package[0].File.Add("Linked/aaaa.cpp");
+				_expects.Package[0].File.Add("Sub0/bbbb.cpp");
+				_expects.Package[0].File.Add("cccc.cpp");
+				sandbox.Parse(_parser, _expects);
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		private void Link(Sandbox sandbox, string target, string name)
+		{
+			Process process = Process.Start("ln", "-s " + target + " " + sandbox.GetPath(name));
+			process.WaitForExit();
+			if (process.ExitCode != 0)
+				throw new InvalidOperationException("Unable to link " + name);
+		}
+
+		[Test]
+		public void Test_IgnoreFileSkipsMatches()
+		{
+			_script.Replace("'somefile.txt'", "matchrecursive('*.cpp')");
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.WriteFile(".premakeignore", "obj/\n*.gen.cpp\n");
+				sandbox.WriteFile("Sub0/.premakeignore", "Vendor/\n");
+				sandbox.AddFile("aaaa.cpp");
+				sandbox.AddFile("aaaa.gen.cpp");
+				sandbox.AddFile("obj/bbbb.cpp");
+				sandbox.AddFile("Sub0/cccc.cpp");
+				sandbox.AddFile("Sub0/cccc.gen.cpp");
+				sandbox.AddFile("Sub0/Vendor/dddd.cpp");
+				sandbox.AddFile("Sub1/Vendor/eeee.cpp");
+
+				sandbox.RunOrFail("--target gnu");
+				_expects.Package[0].File.Add("aaaa.cpp");
+				_expects.Package[0].File.Add("Sub0/cccc.cpp");
+				_expects.Package[0].File.Add("Sub1/Vendor/eeee.cpp");
+				sandbox.Parse(_parser, _expects);
+
+				/* The ignored obj and Sub0/Vendor directories are counted */
+				sandbox.RunOrFail("--verbose --target gnu");
+				Assert.IsTrue(sandbox.Output.IndexOf("Ignored 2 directories") >= 0, sandbox.Output);
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_DirCacheSeesChanges()
+		{
+			_script.Replace("'somefile.txt'", "matchrecursive('*.cpp')");
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.AddFile("aaaa.cpp");
+				sandbox.AddFile("Sub0/bbbb.cpp");
+				sandbox.AddFile("Sub0/cccc.cpp");
+
+				/* Directories changed in the last few seconds aren't cached */
+				Thread.Sleep(3000);
+				sandbox.RunOrFail("--dircache dircache.txt --target gnu");
+				Assert.IsTrue(sandbox.Read("dircache.txt").IndexOf("bbbb.cpp") >= 0, "Listing was not cached");
+
+				/* A file added or removed since must be seen */
+				sandbox.AddFile("Sub0/dddd.cpp");
+				sandbox.Delete("Sub0/cccc.cpp");
+				sandbox.RunOrFail("--dircache dircache.txt --target gnu");
+
+				_expects.Package[0].File.Add("aaaa.cpp");
+				_expects.Package[0].File.Add("Sub0/bbbb.cpp");
+				_expects.Package[0].File.Add("Sub0/dddd.cpp");
+				sandbox.Parse(_parser, _expects);
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_ThreadsGiveSameResults()
+		{
+			/* Searching on several threads finds the same files, in the same order */
+			_script.Replace("'somefile.txt'", "matchrecursive('*.cpp', '*.h', '!*_test.cpp')");
+
+			Sandbox sandbox = new Sandbox();
+			try
+			{
+				sandbox.WriteScript(_script);
+				for (int i = 0; i < 8; ++i)
+				{
+					for (int j = 0; j < 4; ++j)
+					{
+						string dirname = "Sub" + i + "/Sub" + j + "/";
+						sandbox.AddFile(dirname + "file" + j + ".cpp");
+						sandbox.AddFile(dirname + "file" + j + ".h");
+						sandbox.AddFile(dirname + "file" + j + "_test.cpp");
+					}
+					sandbox.AddFile("Sub" + i + "/file.cpp");
+				}
+
+				sandbox.RunOrFail("--threads 1 --target gnu");
+				string serial = sandbox.Read("MyPackage.make");
+
+				sandbox.Delete(".premake.state");
+				sandbox.Delete("MyPackage.make");
+				sandbox.RunOrFail("--threads 8 --target gnu");
+				Assert.AreEqual(serial, sandbox.Read("MyPackage.make"));
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_WatchSeesNewFiles()
+		{
+			_script.Replace("'somefile.txt'", "matchrecursive('*.cpp')");
+
+			Sandbox sandbox = new Sandbox();
+			Process process = null;
+			try
+			{
+				sandbox.WriteScript(_script);
+				sandbox.AddFile("aaaa.cpp");
+				process = sandbox.StartWatching("--target gnu");
+
+				/* A file added below a searched directory regenerates the package */
+				sandbox.AddFile("Sub0/bbbb.cpp");
+				for (int i = 0; i < 100; ++i)
+				{
+					if (sandbox.Read("MyPackage.make").IndexOf("bbbb") >= 0)
+						break;
+					Thread.Sleep(100);
+				}
+				sandbox.StopWatching(process);
+				process = null;
+
+				_expects.Package[0].File.Add("aaaa.cpp");
+				_expects.Package[0].File.Add("Sub0/bbbb.cpp");
+				sandbox.Parse(_parser, _expects);
+			}
+			finally
+			{
+				if (process != null)
+					sandbox.StopWatching(process);
+				sandbox.Close();
+			}
+		}
+
+		#region Git Index
+		/* Set up a work tree with tracked, untracked and ignored files */
+		private Sandbox MakeWorkTree(bool trackAll)
+		{
+			_script.Replace("'somefile.txt'", "matchrecursive('*.cpp')");
+
+			Sandbox sandbox = new Sandbox();
+			sandbox.WriteScript(_script);
+			sandbox.AddFile("aaaa.cpp");
+			sandbox.AddFile("Sub0/bbbb.cpp");
+			sandbox.AddFile("Sub0/cccc.cpp");
+			sandbox.AddFile("dddd.cpp");
+			sandbox.WriteFile(".gitignore", "dddd.cpp\n");
+
+			Git(sandbox, "init -q .");
+			if (trackAll)
+				Git(sandbox, "add -f aaaa.cpp Sub0/bbbb.cpp Sub0/cccc.cpp dddd.cpp");
+			else
+				Git(sandbox, "add aaaa.cpp Sub0/bbbb.cpp .gitignore");
+			return sandbox;
+		}
+
+		private void Git(Sandbox sandbox, string args)
+		{
+			Process process = new Process();
+			process.StartInfo.FileName = "git";
+			process.StartInfo.Arguments = args;
+			process.StartInfo.WorkingDirectory = sandbox.Root;
+			process.StartInfo.UseShellExecute = false;
+			process.Start();
+			process.WaitForExit();
+			if (process.ExitCode != 0)
+				throw new InvalidOperationException("git " + args + " failed");
+		}
+
+		[Test]
+		public void Test_GitIndexFindsTrackedFiles()
+		{
+			Sandbox sandbox = MakeWorkTree(false);
+			try
+			{
+				sandbox.RunOrFail("--gitindex --target gnu");
+				_expects.Package[0].File.Add("aaaa.cpp");
+				_expects.Package[0].File.Add("Sub0/bbbb.cpp");
+				sandbox.Parse(_parser, _expects);
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_GitIndexWithUntrackedFiles()
+		{
+			/* The walk doesn't read .gitignore, so ignored files are found too */
+			Sandbox sandbox = MakeWorkTree(false);
+			try
+			{
+				sandbox.RunOrFail("--gitindex --include-untracked --target gnu");
+				_expects.Package[0].File.Add("aaaa.cpp");
+				_expects.Package[0].File.Add("Sub0/bbbb.cpp");
+				_expects.Package[0].File.Add("Sub0/cccc.cpp");
+				_expects.Package[0].File.Add("dddd.cpp");
+				sandbox.Parse(_parser, _expects);
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+
+		[Test]
+		public void Test_GitIndexMatchesWalk()
+		{
+			/* With every file tracked, the index finds what the walk does */
+			Sandbox sandbox = MakeWorkTree(true);
+			try
+			{
+				sandbox.RunOrFail("--target gnu");
+				string walked = sandbox.Read("MyPackage.make");
+
+				sandbox.Delete(".premake.state");
+				sandbox.Delete("MyPackage.make");
+				sandbox.RunOrFail("--gitindex --target gnu");
+				Assert.AreEqual(walked, sandbox.Read("MyPackage.make"));
+
+				_expects.Package[0].File.Add("aaaa.cpp");
+				_expects.Package[0].File.Add("Sub0/bbbb.cpp");
+				_expects.Package[0].File.Add("Sub0/cccc.cpp");
+				_expects.Package[0].File.Add("dddd.cpp");
+				sandbox.Parse(_parser, _expects);
+			}
+			finally
+			{
+				sandbox.Close();
+			}
+		}
+		#endregion
 	}
 }